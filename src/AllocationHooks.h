@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdlib>
+#include <new>
+
+#include "AllocationTracker.h"
+
+// Replaces the global operator new and delete so every C++ heap allocation is counted by
+// allocations(). Include from exactly one translation unit per executable.
+
+void* operator new(size_t size) {
+    allocations().record(size);
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <sstream>
+#include <string>
+
+// What an allocation is charged to: the subsystem tagged on the allocating thread.
+enum class AllocationSubsystem { Other, Input, Audio, Render, Text, Images, Overlay, Count };
+
+inline const char* allocationSubsystemName(AllocationSubsystem subsystem) {
+    static const char* names[] = {"other", "input", "audio", "render", "text", "images", "overlay"};
+    return names[static_cast<int>(subsystem)];
+}
+
+// Allocations so far, per subsystem. Subtract two snapshots to get what happened in between.
+struct AllocationSnapshot {
+    static constexpr int SubsystemCount = static_cast<int>(AllocationSubsystem::Count);
+
+    Uint64 counts[SubsystemCount] = {};
+    Uint64 bytes[SubsystemCount] = {};
+
+    Uint64 totalCount() const {
+        Uint64 total = 0;
+        for (int i = 0; i < SubsystemCount; ++i) {
+            total += counts[i];
+        }
+        return total;
+    }
+
+    Uint64 totalBytes() const {
+        Uint64 total = 0;
+        for (int i = 0; i < SubsystemCount; ++i) {
+            total += bytes[i];
+        }
+        return total;
+    }
+
+    AllocationSnapshot operator-(const AllocationSnapshot& earlier) const {
+        AllocationSnapshot delta;
+        for (int i = 0; i < SubsystemCount; ++i) {
+            delta.counts[i] = counts[i] - earlier.counts[i];
+            delta.bytes[i] = bytes[i] - earlier.bytes[i];
+        }
+        return delta;
+    }
+
+    // "text 3 (412 B), render 1 (64 B)", leaving out subsystems that did not allocate.
+    std::string describe() const {
+        std::ostringstream out;
+        for (int i = 0; i < SubsystemCount; ++i) {
+            if (counts[i]) {
+                out << (out.tellp() > 0 ? ", " : "") << allocationSubsystemName(static_cast<AllocationSubsystem>(i)) << " "
+                    << counts[i] << " (" << bytes[i] << " B)";
+            }
+        }
+        return out.str();
+    }
+};
+
+// Counts heap allocations from operator new (see AllocationHooks.h) and from SDL's allocator,
+// charged to the subsystem tagged on the calling thread. Recording is two relaxed atomic adds.
+class AllocationTracker {
+public:
+    static constexpr int SubsystemCount = AllocationSnapshot::SubsystemCount;
+
+    void record(size_t size) {
+        int index = static_cast<int>(currentSubsystem());
+        counts[index].fetch_add(1, std::memory_order_relaxed);
+        bytes[index].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    AllocationSnapshot snapshot() const {
+        AllocationSnapshot result;
+        for (int i = 0; i < SubsystemCount; ++i) {
+            result.counts[i] = counts[i].load(std::memory_order_relaxed);
+            result.bytes[i] = bytes[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    static AllocationSubsystem& currentSubsystem() {
+        static thread_local AllocationSubsystem subsystem = AllocationSubsystem::Other;
+        return subsystem;
+    }
+
+    // Routes SDL_malloc and friends (surfaces, textures, SDL_ttf glyphs) through the tracker.
+    // Must run before SDL_Init: memory SDL allocated earlier would be freed by the wrong allocator.
+    bool installSdlHooks();
+
+    SDL_malloc_func sdlMalloc = nullptr;
+    SDL_calloc_func sdlCalloc = nullptr;
+    SDL_realloc_func sdlRealloc = nullptr;
+    SDL_free_func sdlFree = nullptr;
+
+private:
+    std::atomic<Uint64> counts[SubsystemCount] = {};
+    std::atomic<Uint64> bytes[SubsystemCount] = {};
+};
+
+inline AllocationTracker& allocations() {
+    static AllocationTracker tracker;
+    return tracker;
+}
+
+inline void* SDLCALL trackedSdlMalloc(size_t size) {
+    allocations().record(size);
+    return allocations().sdlMalloc(size);
+}
+
+inline void* SDLCALL trackedSdlCalloc(size_t count, size_t size) {
+    allocations().record(count * size);
+    return allocations().sdlCalloc(count, size);
+}
+
+inline void* SDLCALL trackedSdlRealloc(void* memory, size_t size) {
+    allocations().record(size);
+    return allocations().sdlRealloc(memory, size);
+}
+
+inline void SDLCALL trackedSdlFree(void* memory) {
+    allocations().sdlFree(memory);
+}
+
+inline bool AllocationTracker::installSdlHooks() {
+    if (sdlMalloc) {
+        return true;
+    }
+    SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+    if (SDL_SetMemoryFunctions(trackedSdlMalloc, trackedSdlCalloc, trackedSdlRealloc, trackedSdlFree) < 0) {
+        sdlMalloc = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Charges allocations on this thread to a subsystem until the end of the scope.
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocationSubsystem subsystem) : previous(AllocationTracker::currentSubsystem()) {
+        AllocationTracker::currentSubsystem() = subsystem;
+    }
+    ~AllocationScope() { AllocationTracker::currentSubsystem() = previous; }
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    AllocationSubsystem previous;
+};
+
+// PAMPLEMOUSSE_ALLOCATION_SCOPE(Text) tags the rest of the enclosing scope. Without
+// PAMPLEMOUSSE_TRACK_ALLOCATIONS it compiles to nothing.
+#ifdef PAMPLEMOUSSE_TRACK_ALLOCATIONS
+#define PAMPLEMOUSSE_ALLOCATION_NAME2(line) allocationScope##line
+#define PAMPLEMOUSSE_ALLOCATION_NAME(line) PAMPLEMOUSSE_ALLOCATION_NAME2(line)
+#define PAMPLEMOUSSE_ALLOCATION_SCOPE(subsystem) \
+    AllocationScope PAMPLEMOUSSE_ALLOCATION_NAME(__LINE__)(AllocationSubsystem::subsystem)
+#else
+#define PAMPLEMOUSSE_ALLOCATION_SCOPE(subsystem) ((void)0)
+#endif
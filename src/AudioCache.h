@@ -0,0 +1,180 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "CacheFiles.h"
+#include "Log.h"
+
+// Header in front of the raw PCM of a cooked audio file.
+struct CookedAudioHeader {
+    char magic[4];
+    Uint32 version;
+    Sint32 frequency;
+    Uint32 format;   // SDL audio format
+    Sint32 channels;
+    Uint32 reserved0;
+    Uint64 dataBytes;
+    Uint8 reserved[32]; // pads the header to 64 bytes
+};
+static_assert(sizeof(CookedAudioHeader) == 64, "cooked audio header must stay 64 bytes");
+
+// Cooks audio files into PCM at the mixer's device format, cached on disk under
+// $XDG_CACHE_HOME/pamplemousse/audio, so nothing is decoded or resampled while playing.
+// Short clips come back as Mix_Chunks over the memory-mapped PCM; themes are streamed
+// from the cooked file by PcmStream.
+class AudioCache {
+public:
+    bool init() {
+        Uint16 deviceFormat;
+        if (!Mix_QuerySpec(&frequency, &deviceFormat, &channels)) {
+            logWarning() << "Audio cache disabled: audio device is not open";
+            return false;
+        }
+        format = deviceFormat;
+        std::string root = cacheRoot();
+        directory = root.empty() ? root : root + "/audio";
+        enabled = !directory.empty() && makeDirectories(directory);
+        if (!enabled) {
+            logWarning() << "Audio cache disabled: cannot create " << directory;
+        }
+        return enabled;
+    }
+
+    bool isEnabled() const { return enabled; }
+    int getFrequency() const { return frequency; }
+    Uint16 getFormat() const { return format; }
+    int getChannels() const { return channels; }
+    int frameBytes() const { return SDL_AUDIO_BITSIZE(format) / 8 * channels; }
+
+    // Decodes and resamples a source file to the device format once and stores the PCM on disk.
+    // Returns the cooked file path, or an empty string with error set. Safe on worker threads.
+    std::string cook(const std::string& sourcePath, std::string& error) const {
+        if (!enabled) {
+            error = "audio cache disabled";
+            return "";
+        }
+        std::vector<Uint8> source;
+        if (!readFileBytes(sourcePath, source)) {
+            error = "cannot read " + sourcePath;
+            return "";
+        }
+        Uint64 hash = fnv1a64(source.data(), source.size());
+        char name[96];
+        snprintf(name, sizeof(name), "%016llx-%d-%04x-%d.pcm", static_cast<unsigned long long>(hash), frequency, format, channels);
+        std::string path = directory + "/" + name;
+        CookedAudioHeader header;
+        if (readHeader(path, header)) {
+            return path;
+        }
+
+        // Mix_LoadWAV_RW decodes any format the mixer supports and converts it to the device format.
+        Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(source.data(), static_cast<int>(source.size())), 1);
+        if (!chunk) {
+            error = Mix_GetError();
+            return "";
+        }
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, Magic, sizeof(header.magic));
+        header.version = Version;
+        header.frequency = frequency;
+        header.format = format;
+        header.channels = channels;
+        header.dataBytes = chunk->alen;
+        bool written = writeFileAtomically(path, &header, sizeof(header), chunk->abuf, chunk->alen);
+        Mix_FreeChunk(chunk);
+        if (!written) {
+            error = "cannot write " + path;
+            return "";
+        }
+        return path;
+    }
+
+    // Returns a chunk playing straight from the cooked PCM, cooking it first if needed. Main thread.
+    Mix_Chunk* loadChunk(const std::string& sourcePath) {
+        auto it = chunks.find(sourcePath);
+        if (it != chunks.end()) {
+            return it->second.chunk;
+        }
+        std::string error;
+        std::string cookedPath = cook(sourcePath, error);
+        if (cookedPath.empty()) {
+            logError() << "Failed to cook " << sourcePath << ": " << error;
+            return nullptr;
+        }
+        size_t size = 0;
+        std::shared_ptr<void> mapping = mapFile(cookedPath, size);
+        if (!mapping || size < sizeof(CookedAudioHeader)) {
+            logError() << "Failed to map cooked audio " << cookedPath;
+            return nullptr;
+        }
+        const CookedAudioHeader* header = static_cast<const CookedAudioHeader*>(mapping.get());
+        Uint8* pcm = static_cast<Uint8*>(mapping.get()) + sizeof(CookedAudioHeader);
+        Mix_Chunk* chunk = Mix_QuickLoad_RAW(pcm, static_cast<Uint32>(header->dataBytes));
+        if (!chunk) {
+            logError() << "Failed to create chunk for " << sourcePath << ": " << Mix_GetError();
+            return nullptr;
+        }
+        chunks[sourcePath] = {chunk, mapping, static_cast<Uint64>(header->dataBytes)};
+        return chunk;
+    }
+
+    Uint64 chunkBytes(const std::string& sourcePath) const {
+        auto it = chunks.find(sourcePath);
+        return it == chunks.end() ? 0 : it->second.bytes;
+    }
+
+    void freeChunk(const std::string& sourcePath) {
+        auto it = chunks.find(sourcePath);
+        if (it != chunks.end()) {
+            Mix_FreeChunk(it->second.chunk); // QuickLoad chunks do not own their samples
+            chunks.erase(it);
+        }
+    }
+
+    void freeChunks() {
+        for (auto& entry : chunks) {
+            Mix_FreeChunk(entry.second.chunk);
+        }
+        chunks.clear();
+    }
+
+    // Reads and validates the header of a cooked file against the current device format.
+    bool readHeader(const std::string& path, CookedAudioHeader& header) const {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        bool valid = read(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+                     std::memcmp(header.magic, Magic, sizeof(header.magic)) == 0 && header.version == Version &&
+                     header.frequency == frequency && header.format == format && header.channels == channels &&
+                     lseek(fd, 0, SEEK_END) == static_cast<off_t>(sizeof(header) + header.dataBytes);
+        close(fd);
+        return valid;
+    }
+
+private:
+    struct CachedChunk {
+        Mix_Chunk* chunk;
+        std::shared_ptr<void> mapping;
+        Uint64 bytes;
+    };
+
+    static constexpr const char* Magic = "PMPC";
+    static const Uint32 Version = 1;
+
+    std::string directory;
+    bool enabled = false;
+    int frequency = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    std::unordered_map<std::string, CachedChunk> chunks;
+};
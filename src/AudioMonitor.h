@@ -0,0 +1,201 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "CacheFiles.h"
+#include "Log.h"
+#include "RingBuffer.h"
+#include "Stats.h"
+#include "StreamMixer.h"
+
+// Watches the audio callback from a post-mix hook. The hook only timestamps the callback and
+// pushes a sample to a lock-free queue; the main thread turns samples into callback interval,
+// jitter, late-callback and time-to-audible figures in the StatsRegistry, next to frame timing.
+// It also owns the post-mix slot, so it runs the voice-over stage before measuring.
+class AudioMonitor {
+public:
+    struct Calibration {
+        int bufferFrames;
+        Uint64 callbacks;
+        Uint64 lateCallbacks;
+        double p99JitterMs;
+        bool stable;
+    };
+
+    void init(StreamMixer* postMixStage) {
+        stage = postMixStage;
+        querySpec();
+    }
+
+    void install() {
+        if (!installed && frequency > 0) {
+            lastCallback = 0;
+            Mix_SetPostMix(postMixCallback, this);
+            installed = true;
+        }
+    }
+
+    void uninstall() {
+        if (installed) {
+            Mix_SetPostMix(nullptr, nullptr); // waits for a callback in flight
+            installed = false;
+        }
+    }
+
+    // Call right after starting a sound; the next callback reports how long until it is heard.
+    void markTrigger() { pendingTrigger.store(SDL_GetPerformanceCounter(), std::memory_order_release); }
+
+    // Moves the samples recorded by the audio thread into stats. Main thread, once per frame.
+    void collect(StatsRegistry& stats) {
+        Sample sample;
+        while (samples.pop(sample)) {
+            double periodMs = sample.frames * 1000.0 / frequency;
+            if (sample.intervalTicks) {
+                double intervalMs = ticksToMs(sample.intervalTicks);
+                stats.add("audio callback", intervalMs);
+                stats.add("audio jitter", std::fabs(intervalMs - periodMs));
+                // SDL cannot report device underruns; a callback this late means the device ran dry.
+                if (intervalMs > periodMs * LateFactor) {
+                    stats.count("audio late callbacks");
+                }
+            }
+            if (sample.triggerTicks) {
+                // The triggered sound is in the buffer just mixed, heard once the buffer ahead of it plays out.
+                stats.add("time to audible", ticksToMs(sample.triggerTicks) + periodMs);
+            }
+            stats.set("audio buffer frames", sample.frames);
+        }
+        Uint64 dropped = droppedSamples.exchange(0);
+        if (dropped) {
+            stats.count("audio samples dropped", dropped);
+        }
+    }
+
+    // Opens the device at each candidate buffer size in turn, listens for msEach and keeps the
+    // smallest size with no late callbacks and p99 jitter under a quarter of the period, then
+    // reopens the device with restoreFrames. Reopening resets the mixer's channels, so run it
+    // before anything plays. Returns 0 if no size was stable.
+    int calibrate(const std::vector<int>& candidates, int msEach, int restoreFrames, std::vector<Calibration>& results) {
+        int deviceFrequency = frequency;
+        Uint16 deviceFormat = format;
+        int deviceChannels = channels;
+        StreamMixer* savedStage = stage;
+        stage = nullptr;
+        int best = 0;
+        for (int frames : candidates) {
+            uninstall();
+            Mix_CloseAudio();
+            StatsRegistry previous;
+            collect(previous); // drop samples from the previous size
+            if (Mix_OpenAudio(deviceFrequency, deviceFormat, deviceChannels, frames) < 0) {
+                logWarning() << "Calibration: cannot open audio with " << frames << " frames: " << Mix_GetError();
+                continue;
+            }
+            querySpec();
+            install();
+            StatsRegistry stats;
+            Uint32 start = SDL_GetTicks();
+            while (SDL_GetTicks() - start < static_cast<Uint32>(msEach)) {
+                SDL_Delay(10);
+                collect(stats);
+            }
+            const RollingStat* jitter = stats.find("audio jitter");
+            double periodMs = frames * 1000.0 / frequency;
+            Calibration result;
+            result.bufferFrames = frames;
+            result.callbacks = jitter ? jitter->count() : 0;
+            result.lateCallbacks = stats.counter("audio late callbacks");
+            result.p99JitterMs = jitter ? jitter->percentile(0.99) : 0.0;
+            result.stable = result.callbacks > 0 && result.lateCallbacks == 0 && result.p99JitterMs < periodMs / 4;
+            results.push_back(result);
+            if (result.stable && (best == 0 || frames < best)) {
+                best = frames;
+            }
+        }
+        uninstall();
+        Mix_CloseAudio();
+        if (Mix_OpenAudio(deviceFrequency, deviceFormat, deviceChannels, restoreFrames) < 0) {
+            logError() << "Calibration: cannot reopen audio: " << Mix_GetError();
+        }
+        querySpec();
+        stage = savedStage;
+        install();
+        return best;
+    }
+
+    // Buffer size picked by the last calibration on this machine, or 0.
+    static int loadCalibratedBufferFrames() {
+        std::vector<Uint8> bytes;
+        if (!readFileBytes(calibrationPath(), bytes)) {
+            return 0;
+        }
+        return std::atoi(std::string(bytes.begin(), bytes.end()).c_str());
+    }
+
+    static bool saveCalibratedBufferFrames(int frames) {
+        std::string root = cacheRoot();
+        if (root.empty() || !makeDirectories(root)) {
+            return false;
+        }
+        std::string text = std::to_string(frames) + "\n";
+        return writeFileAtomically(calibrationPath(), text.data(), text.size(), nullptr, 0);
+    }
+
+    static const int DefaultBufferFrames = 2048;
+
+private:
+    struct Sample {
+        Uint64 intervalTicks; // since the previous callback, 0 for the first
+        Uint64 triggerTicks;  // since a sound was triggered, 0 if none was
+        Uint32 frames;
+    };
+
+    static constexpr double LateFactor = 1.5;
+
+    StreamMixer* stage = nullptr;
+    int frequency = 0;
+    Uint16 format = MIX_DEFAULT_FORMAT;
+    int channels = 2;
+    int frameBytes = 4;
+    bool installed = false;
+    Uint64 lastCallback = 0; // audio thread only
+    std::atomic<Uint64> pendingTrigger{0};
+    std::atomic<Uint64> droppedSamples{0};
+    SpscQueue<Sample, 512> samples; // audio -> main
+
+    static std::string calibrationPath() { return cacheRoot() + "/audio-buffer"; }
+
+    void querySpec() {
+        if (!Mix_QuerySpec(&frequency, &format, &channels)) {
+            frequency = 0;
+            return;
+        }
+        frameBytes = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    }
+
+    static void SDLCALL postMixCallback(void* udata, Uint8* stream, int len) {
+        static_cast<AudioMonitor*>(udata)->postMix(stream, len);
+    }
+
+    void postMix(Uint8* stream, int len) {
+        if (stage) {
+            stage->mix(stream, len);
+        }
+        Uint64 now = SDL_GetPerformanceCounter();
+        Uint64 trigger = pendingTrigger.exchange(0, std::memory_order_acq_rel);
+        Sample sample;
+        sample.intervalTicks = lastCallback ? now - lastCallback : 0;
+        sample.triggerTicks = trigger ? now - trigger : 0;
+        sample.frames = static_cast<Uint32>(len / frameBytes);
+        lastCallback = now;
+        if (!samples.push(sample)) {
+            droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Helpers shared by the on-disk caches under $XDG_CACHE_HOME/pamplemousse and the saves under
+// $XDG_DATA_HOME/pamplemousse.
+
+inline std::string cacheRoot() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        return std::string(xdg) + "/pamplemousse";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::string(home) + "/.cache/pamplemousse";
+    }
+    return "";
+}
+
+// Where files the player would miss live, unlike the caches, which can be rebuilt.
+inline std::string dataRoot() {
+    const char* xdg = std::getenv("XDG_DATA_HOME");
+    if (xdg && *xdg) {
+        return std::string(xdg) + "/pamplemousse";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::string(home) + "/.local/share/pamplemousse";
+    }
+    return "";
+}
+
+inline bool makeDirectories(const std::string& path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string prefix = slash == std::string::npos ? path : path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+// 64-bit FNV-1a; pass a previous result as seed to hash several buffers as one.
+inline Uint64 fnv1a64(const void* data, size_t size, Uint64 seed = 14695981039346656037ULL) {
+    const Uint8* bytes = static_cast<const Uint8*>(data);
+    Uint64 hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Flushes a file's data to the storage device. On macOS fsync only reaches the drive's cache,
+// so F_FULLFSYNC is asked for first.
+inline bool syncFile(int fd) {
+#ifdef __APPLE__
+    if (fcntl(fd, F_FULLFSYNC) == 0) {
+        return true;
+    }
+#endif
+    return fsync(fd) == 0;
+}
+
+// Makes a rename in the directory holding path survive a crash.
+inline bool syncParentDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+// Writes a header and a payload to a temp file next to path, then renames it into place, so
+// readers only ever see complete files. A durable write also syncs the file before the rename
+// and the directory after it, so a crash or power cut leaves the old file or the new one, never
+// an empty one; caches skip that, since losing one only costs a rebuild.
+inline bool writeFileAtomically(const std::string& path, const void* header, size_t headerBytes, const void* data, size_t dataBytes,
+                                bool durable = false) {
+    static std::atomic<Uint64> tempCounter{0};
+    std::string tempPath = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(tempCounter++);
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = writeAll(fd, header, headerBytes) && writeAll(fd, data, dataBytes) && (!durable || syncFile(fd));
+    written = close(fd) == 0 && written;
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+    return !durable || syncParentDirectory(path);
+}
+
+// Maps a whole file read-only. The mapping lives as long as the returned pointer.
+inline std::shared_ptr<void> mapFile(const std::string& path, size_t& size) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    size_t mappedSize = size;
+    return std::shared_ptr<void>(mapping, [mappedSize](void* p) { munmap(p, mappedSize); });
+}
+
+inline bool readFileBytes(const std::string& path, std::vector<Uint8>& out) {
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    Sint64 size = SDL_RWsize(file);
+    if (size < 0) {
+        SDL_RWclose(file);
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    size_t read = size > 0 ? SDL_RWread(file, out.data(), 1, out.size()) : 0;
+    SDL_RWclose(file);
+    return read == out.size();
+}
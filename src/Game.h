@@ -0,0 +1,1484 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "AllocationTracker.h"
+#include "AudioCache.h"
+#include "AudioMonitor.h"
+#include "ImageDiskCache.h"
+#include "InputLog.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "RenderThread.h"
+#include "ResidencyManager.h"
+#include "SaveGame.h"
+#include "Sequence.h"
+#include "SoundEffects.h"
+#include "StartupProfiler.h"
+#include "Stats.h"
+#include "StreamMixer.h"
+#include "TextLayout.h"
+#include "TexturePool.h"
+#include "Trace.h"
+#include "VoiceTrack.h"
+#include "WarmupBatch.h"
+#include "core/Story.h"
+#include "core/StoryNavigator.h"
+
+// Settings that can be changed from the command line
+struct GameOptions {
+    int textureBudgetMB = 256; // GPU memory for resident background images
+    int musicBudgetMB = 64;    // open themes, least recently played closed first
+    int imageCacheMB = 512;    // on-disk cache of decoded images, 0 disables it
+    bool imageCacheBenchmark = false;
+    int warmupDepth = 2;       // choices deep from each chapter's first scene to warm up in the menu
+    bool cookAudio = false;    // cook every theme to device-format PCM and exit
+    int sfxStressSeconds = 0;  // fire sound effects at StressTriggersPerSecond for this long and exit
+    int audioBufferFrames = 0; // 0 uses the calibrated size, or AudioMonitor::DefaultBufferFrames
+    bool calibrateAudio = false; // find the smallest stable audio buffer, save it and exit
+    bool softwareRenderer = false; // render without the GPU (headless benchmark)
+    int traceSeconds = 0;      // record a Chrome trace for this long, 0 disables it
+    std::string tracePath = "pamplemousse-trace.json";
+    std::string recordInputPath; // write the events the game consumes to this log
+    std::string replayInputPath; // feed a recorded log back in at the same frames
+    bool replayFast = false;     // skip frame delays while replaying
+    bool replayThenQuit = false; // quit when the replayed log runs out
+    bool serialInit = false;     // run the start-up phases one after another, for comparison
+    int metricsPort = 0;         // serve Prometheus metrics on 127.0.0.1:port, 0 disables it
+    bool renderThread = false;   // experimental: draw on a dedicated thread (see RenderThread); off, the main thread draws
+    int jobThreads = 0;          // threads for background jobs (decoding, cooking, prefetch), 0 uses one per core
+    bool saveGames = true;       // autosave on each scene and save on F5; off for replays and benchmarks
+    int saveSlot = 1;            // slot F5 saves to
+    int resumeSlot = SaveSlots::AutosaveSlot; // slot to resume from at start-up, -1 starts at the menu
+};
+
+// A background image kept resident as a pooled texture
+struct CachedImage {
+    SDL_Texture* texture;
+    int w;
+    int h;
+    ResidencyManager::AssetID residencyID;
+};
+
+// A theme kept open so switching chapters does not reload it
+struct LoadedMusic {
+    Mix_Music* music;
+    ResidencyManager::AssetID residencyID;
+};
+
+// Result of preparing a theme on a worker thread: the cooked PCM to stream, or an opened
+// Mix_Music when cooking failed (SDL errors are per thread, so the message travels with it)
+struct MusicLoad {
+    std::string cookedPath;
+    Mix_Music* music;
+    std::string error;
+};
+
+// The font opened by a start-up job, with TTF's message when it failed, for the same reason
+struct FontLoad {
+    TTF_Font* font;
+    std::string error;
+};
+
+// A wrapped line rendered once and kept while it stays on screen
+struct LineTexture {
+    SDL_Texture* texture;
+    int w;
+    int h;
+    Uint64 lastUsed; // rendered frame index
+    ResidencyManager::AssetID residencyID;
+};
+
+// What a scene frame shows, as indices into the game's background and text box tables
+struct SceneFrameIDs {
+    int background;
+    int text;
+};
+
+class Game {
+private:
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    bool isRunning;
+    Story story;
+    StoryNavigator navigator; // which chapter and scene are showing, or the menu
+    Mix_Music* currentMusic;
+    TexturePool texturePool;
+    bool yuvUploads; // JPEG backgrounds go up as IYUV textures when the renderer supports it
+    GameOptions options;
+    ResidencyManager residency;
+    std::unordered_map<std::string, CachedImage> imageCache;
+    ImageDiskCache diskCache;
+    ResidencyManager::AssetID fontAsset;
+    std::unordered_map<std::string, LoadedMusic> loadedMusic;
+    std::string currentMusicPath;
+    std::string pendingMusicPath;      // theme to start once it is open and the old one has faded out
+    std::string loadingMusicPath;      // theme being opened on a worker thread
+    std::future<MusicLoad> musicLoad;
+    static const int MusicFadeMs = 800;
+    int audioBufferFrames;
+    AudioMonitor audioMonitor;
+    StatsRegistry stats;
+    Uint64 lastPresent;
+    bool showOverlay;
+    AudioCache audioCache;
+    StreamMixer streamMixer;
+    SoundEffects soundEffects;
+    VoiceTrack voiceTrack;
+    static const int EffectChannels = 16;
+    static const int StressTriggersPerSecond = 500;
+    static const int StressSkipped = 77; // exit status when the effects are missing, CTest's usual skip code
+    std::unordered_map<std::string, std::string> cookedThemes; // source path -> cooked PCM path
+    std::unordered_map<int, std::unordered_map<std::string, TextLayout>> textLayouts; // by line width, then text
+    std::vector<std::pair<std::string, int>> pendingLayouts; // warm-up text blocks still to wrap
+    std::unordered_map<std::string, LineTexture> lineTextures;
+    static const int LineTextureIdleFrames = 50; // released after this many frames off screen
+    Uint64 frameIndex;
+    std::vector<std::string> menuLabels; // "1. Poulpe", ... built with the chapters
+    AllocationSnapshot lastFrameAllocations;
+    int steadyFrames; // frames rendered on the current scene, for the allocation check
+    int lastFrameScene;
+    int lastFrameChapter;
+    bool allocationReported; // steady-state allocation already printed for this scene
+    static const int SteadyStateFrames = 10;
+    InputRecorder inputRecorder;
+    InputReplayer inputReplayer;
+    StartupProfiler startup;
+    EngineMetrics metrics;
+    MetricsServer metricsServer;
+    WarmupBatch warmup;
+    Uint64 warmupStart;
+
+    // The main thread owns the logic, input and audio; the render thread (or the main thread
+    // without one) owns the renderer and everything above it that draws: images, line textures,
+    // layouts, `stats` and the overlay. `residency` is shared: each side registers, touches and
+    // evicts its own asset classes.
+    RenderThread renderThread;
+    int windowWidth = 0;  // cached at creation, the window is not resizable
+    int windowHeight = 0;
+    std::vector<std::string> backgroundPaths;         // background image table of FrameDescription
+    std::vector<const std::string*> textBoxes;        // text box table, pointing into the story
+    std::vector<std::vector<SceneFrameIDs>> sceneFrames; // by chapter, then scene
+    Uint8 pendingRequests = 0;     // FrameDescription::Request bits for the next frame
+    Uint64 lastEventTicks = 0;     // performance counter when the last event was polled
+    Uint64 pendingInputTicks = 0;  // input the next frame answers
+    StatsRegistry mainStats;       // input, audio and allocation stats, kept by the main thread
+    Sequencer sequencer;           // timed behaviour: the menu, scene transitions
+    bool inTransition = false;     // between two scenes; the screen stays black
+    bool menuOpen = false;         // chapterMenu() is running
+    static const int TransitionMs = 300;
+    static const int MenuFrameMs = 16;   // leaves the cores to the warm-up jobs
+    static const int SceneFrameMs = 100;
+    WarmupBatch musicWarmup;
+    Uint64 musicWarmupStart = 0;
+    SaveSlots saves;
+    SaveState progress;            // what the next save holds, kept by the main thread
+    bool resumePending = false;    // progress came from a save; run() starts there
+    // Render side
+    Uint64 renderedFrames = 0;
+    FrameDescription::Kind lastDrawnKind = FrameDescription::Quit; // none yet
+    int drawnChapter = -1;
+    int drawnScene = -1;
+
+public:
+    explicit Game(const GameOptions& options = GameOptions()) : window(nullptr), renderer(nullptr), font(nullptr), isRunning(true), currentMusic(nullptr), yuvUploads(false), options(options), fontAsset(0), audioBufferFrames(0), lastPresent(0), showOverlay(false), frameIndex(0), steadyFrames(0), lastFrameScene(-1), lastFrameChapter(-1), allocationReported(false), warmupStart(0) {}
+
+    const GameOptions& getOptions() const { return options; }
+
+    bool init(const char* title, int width, int height) {
+        startup.begin();
+        jobs().start(static_cast<unsigned>(std::max(0, options.jobThreads)));
+        if (options.traceSeconds > 0 && tracer().start(options.tracePath, options.traceSeconds)) {
+            tracer().nameThread("main");
+        }
+#ifdef PAMPLEMOUSSE_TRACK_ALLOCATIONS
+        if (!allocations().installSdlHooks()) {
+            logWarning() << "Could not hook SDL's allocator; SDL allocations will not be counted";
+        }
+#endif
+        {
+            StartupPhase phase(startup, "SDL init", "main");
+            if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+                logError() << "SDL could not initialize! SDL_Error: " << SDL_GetError();
+                return false;
+            }
+
+            if (TTF_Init() == -1) {
+                logError() << "SDL_ttf could not initialize! TTF_Error: " << TTF_GetError();
+                return false;
+            }
+
+            if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+                logError() << "SDL_image could not initialize! IMG_Error: " << IMG_GetError();
+                return false;
+            }
+        }
+
+        // The audio device, the font and the story do not need the window, so they load as jobs
+        // while the main thread creates the window and renderer. With serialInit they run here,
+        // one after another, when their results are collected.
+        std::future<bool> audioReady = startInitJob([this]() { return initAudio(); });
+        std::future<FontLoad> fontReady = startInitJob([this]() {
+            StartupPhase phase(startup, "font", startupThread());
+            FontLoad loaded{TTF_OpenFont("../fonts/Avenir.ttc", 24), std::string()};
+            loaded.error = loaded.font ? std::string() : std::string(TTF_GetError());
+            return loaded;
+        });
+        std::future<void> storyReady = startInitJob([this]() {
+            StartupPhase phase(startup, "story", startupThread());
+            loadChapters();
+            diskCache.init(static_cast<Uint64>(options.imageCacheMB) * 1024 * 1024);
+        });
+
+        bool videoReady = initVideo(title, width, height);
+        bool audioOk = audioReady.get();
+        FontLoad fontLoad = fontReady.get();
+        font = fontLoad.font;
+        storyReady.get();
+        saves.setStory(story);
+        if (options.resumeSlot >= 0) {
+            loadSave(options.resumeSlot);
+        }
+        progress.fit(story);
+        if (videoReady && options.renderThread) {
+            videoReady = renderThread.waitUntilReady();
+        }
+        if (!videoReady || !audioOk) {
+            return false;
+        }
+        if (!font) {
+            logError() << "Failed to load font! TTF_Error: " << fontLoad.error;
+            return false;
+        }
+        ResidencyManager::Budget musicBudget;
+        musicBudget.cpuBytes = static_cast<Uint64>(options.musicBudgetMB) * 1024 * 1024;
+        residency.setBudget(AssetClass::Music, musicBudget);
+        fontAsset = residency.registerAsset(AssetClass::Font, "../fonts/Avenir.ttc", ResidencyManager::fileBytes("../fonts/Avenir.ttc"), 0);
+
+        if (!options.replayInputPath.empty() && !inputReplayer.load(options.replayInputPath, options.replayFast, options.replayThenQuit)) {
+            return false;
+        }
+        if (!options.recordInputPath.empty()) {
+            inputRecorder.start(options.recordInputPath);
+        }
+        if (options.metricsPort > 0) {
+            metricsServer.start(options.metricsPort, metrics); // the game runs without it if the port is taken
+        }
+        return true;
+    }
+
+    template <typename Function>
+    std::future<decltype(std::declval<Function>()())> startInitJob(Function function) {
+        if (options.serialInit) {
+            return std::async(std::launch::deferred, std::move(function));
+        }
+        return jobs().async(std::move(function), JobPriority::High);
+    }
+
+    // Label for start-up phases on the calling thread.
+    const char* startupThread() const { return options.serialInit ? "main" : "job worker"; }
+
+    // Opens the audio device and everything that plays through it. Runs as a job.
+    bool initAudio() {
+        const char* thread = startupThread();
+        {
+            StartupPhase phase(startup, "audio device", thread);
+            audioBufferFrames = options.audioBufferFrames > 0 ? options.audioBufferFrames : AudioMonitor::loadCalibratedBufferFrames();
+            if (audioBufferFrames <= 0) {
+                audioBufferFrames = AudioMonitor::DefaultBufferFrames;
+            }
+            if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, audioBufferFrames) < 0) {
+                logError() << "SDL_mixer could not initialize! Mix_Error: " << Mix_GetError();
+                return false;
+            }
+        }
+        StartupPhase phase(startup, "audio assets", thread);
+        if (audioCache.init()) {
+            streamMixer.init(audioCache, audioBufferFrames);
+        }
+        soundEffects.init(audioCache, EffectChannels); // missing effects stay silent
+        for (int i = 0; i < static_cast<int>(SoundEffectID::Count); ++i) {
+            SoundEffectID id = static_cast<SoundEffectID>(i);
+            if (Uint64 bytes = soundEffects.chunkBytes(id)) {
+                residency.registerAsset(AssetClass::Sound, soundEffectDef(id).path, bytes, 0); // pinned: any can fire at any time
+            }
+        }
+        voiceTrack.init(audioCache, audioBufferFrames);
+        audioMonitor.init(voiceTrack.getMixer());
+        audioMonitor.install();
+        return true;
+    }
+
+    // The window, which SDL wants on the main thread along with its events, then the renderer:
+    // here without a render thread, otherwise on that thread, which init() waits for.
+    bool initVideo(const char* title, int width, int height) {
+        {
+            StartupPhase phase(startup, "window", "main");
+            window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_SHOWN);
+            if (!window) {
+                logError() << "Window could not be created! SDL_Error: " << SDL_GetError();
+                return false;
+            }
+            SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+        }
+        if (!options.renderThread) {
+            return initRenderer();
+        }
+        renderThread.start([this]() { return initRenderer(); }, [this](const FrameDescription& frame) { drawFrame(frame); },
+                           [this]() { releaseRenderResources(); });
+        return true;
+    }
+
+    // Renderer, texture pool and GPU budgets, on the thread that will draw.
+    bool initRenderer() {
+        StartupPhase phase(startup, "renderer", options.renderThread ? "render" : "main");
+        renderer = SDL_CreateRenderer(window, -1, options.softwareRenderer ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED);
+        if (!renderer) {
+            logError() << "Renderer could not be created! SDL_Error: " << SDL_GetError();
+            return false;
+        }
+        texturePool.init(renderer);
+        yuvUploads = texturePool.supportsFormat(SDL_PIXELFORMAT_IYUV);
+        if (yuvUploads) {
+            // JPEG stores full-range BT.601, which SDL must use when converting back to RGB.
+            SDL_SetYUVConversionMode(SDL_YUV_CONVERSION_JPEG);
+        }
+
+        ResidencyManager::Budget textureBudget;
+        textureBudget.gpuBytes = static_cast<Uint64>(options.textureBudgetMB) * 1024 * 1024;
+        textureBudget.policy = EvictionPolicy::GraphDistance;
+        residency.setBudget(AssetClass::Texture, textureBudget);
+        return true;
+    }
+
+    void loadChapters() {
+        story.setChapters(buildChapters());
+        navigator.reset(story);
+
+        menuLabels.clear();
+        for (int i = 0; i < story.chapterCount(); ++i) {
+            menuLabels.push_back(std::to_string(i + 1) + ". " + story.chapter(i).title);
+        }
+
+        // Frames name what they show by index, so nothing is copied per frame.
+        backgroundPaths.clear();
+        textBoxes.clear();
+        sceneFrames.assign(story.chapterCount(), std::vector<SceneFrameIDs>());
+        for (int c = 0; c < story.chapterCount(); ++c) {
+            for (const Scene& scene : story.chapter(c).scenes) {
+                SceneFrameIDs ids = {-1, static_cast<int>(textBoxes.size())};
+                textBoxes.push_back(&scene.textBox);
+                if (!scene.imagePath.empty()) {
+                    auto it = std::find(backgroundPaths.begin(), backgroundPaths.end(), scene.imagePath);
+                    ids.background = static_cast<int>(it - backgroundPaths.begin());
+                    if (it == backgroundPaths.end()) {
+                        backgroundPaths.push_back(scene.imagePath);
+                    }
+                }
+                sceneFrames[c].push_back(ids);
+            }
+        }
+    }
+
+    // Switches to the chapter's theme without blocking: the theme is cooked (or opened) on a worker
+    // thread while the old one fades out, then faded in by updateMusic() once it is ready.
+    void playChapterMusic() {
+        std::string musicPath = navigator.chapter().themeMusicPath;
+        if (musicPath == currentMusicPath && isMusicAudible()) {
+            pendingMusicPath.clear();
+            return; // the same theme just keeps playing
+        }
+        if (Mix_PlayingMusic() && Mix_FadingMusic() != MIX_FADING_OUT) {
+            Mix_FadeOutMusic(MusicFadeMs);
+        }
+        streamMixer.fadeOut(MusicFadeMs); // a cooked theme crossfades over this in updateMusic()
+        pendingMusicPath = musicPath;
+        updateMusic();
+    }
+
+    bool isMusicAudible() const {
+        return (Mix_PlayingMusic() && Mix_FadingMusic() != MIX_FADING_OUT) || (streamMixer.isPlaying() && !streamMixer.isFadingOut());
+    }
+
+    // Prepares a theme for playback. Safe on worker threads.
+    MusicLoad prepareMusic(const std::string& musicPath) const {
+        TraceScope trace("music load", "audio");
+        MusicLoad loaded{std::string(), nullptr, std::string()};
+        if (audioCache.isEnabled()) {
+            loaded.cookedPath = audioCache.cook(musicPath, loaded.error);
+            if (!loaded.cookedPath.empty()) {
+                return loaded;
+            }
+        }
+        loaded.music = Mix_LoadMUS(musicPath.c_str()); // fall back to decoding while playing
+        loaded.error = loaded.music ? std::string() : std::string(Mix_GetError());
+        return loaded;
+    }
+
+    // Takes ownership of a prepared theme. Main thread.
+    void insertPreparedMusic(const std::string& musicPath, const MusicLoad& loaded) {
+        if (!loaded.cookedPath.empty()) {
+            cookedThemes[musicPath] = loaded.cookedPath;
+        } else if (loadedMusic.count(musicPath)) {
+            Mix_FreeMusic(loaded.music);
+        } else {
+            insertMusic(musicPath, loaded.music);
+        }
+    }
+
+    // Advances the theme transition. Called once per frame from the menu and the main loop.
+    void updateMusic() {
+        streamMixer.update();
+        if (musicLoad.valid() && musicLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            MusicLoad loaded = musicLoad.get();
+            if (loaded.cookedPath.empty() && !loaded.music) {
+                logError() << "Failed to load music! Mix_Error: " << loaded.error;
+                if (pendingMusicPath == loadingMusicPath) {
+                    pendingMusicPath.clear();
+                }
+            } else {
+                insertPreparedMusic(loadingMusicPath, loaded);
+            }
+            loadingMusicPath.clear();
+        }
+
+        if (pendingMusicPath.empty()) {
+            return;
+        }
+        auto cooked = cookedThemes.find(pendingMusicPath);
+        if (cooked != cookedThemes.end()) {
+            if (Mix_PlayingMusic()) {
+                return; // the hook replaces Mix_Music output, so let a fallback theme fade out first
+            }
+            PcmStream* stream = new PcmStream();
+            if (!stream->open(audioCache, cooked->second, true, static_cast<size_t>(audioCache.getFrequency()) * audioCache.frameBytes())) {
+                logError() << "Failed to stream " << cooked->second;
+                delete stream;
+                pendingMusicPath.clear();
+                return;
+            }
+            streamMixer.play(stream, MusicFadeMs);
+            currentMusic = nullptr;
+            currentMusicPath = pendingMusicPath;
+            pendingMusicPath.clear();
+            return;
+        }
+
+        auto it = loadedMusic.find(pendingMusicPath);
+        if (it == loadedMusic.end()) {
+            if (!musicLoad.valid()) {
+                loadingMusicPath = pendingMusicPath;
+                std::string path = pendingMusicPath;
+                musicLoad = jobs().async([this, path]() { return prepareMusic(path); }, JobPriority::High); // the player is waiting for it
+            }
+            return;
+        }
+        if (Mix_PlayingMusic() || streamMixer.isPlaying()) {
+            return; // wait for the old theme to finish fading out
+        }
+        streamMixer.uninstall();
+
+        currentMusic = it->second.music;
+        currentMusicPath = pendingMusicPath;
+        pendingMusicPath.clear();
+        Mix_FadeInMusic(currentMusic, -1, MusicFadeMs); // Play music in a loop
+    }
+
+    // Per-frame audio housekeeping: warmed-up themes, theme transitions, voice-over prefetch and audio stats.
+    void updateAudio() {
+        musicWarmup.pump();
+        updateMusic();
+        voiceTrack.update();
+        audioMonitor.collect(mainStats);
+        mainStats.set("music stream underruns", streamMixer.getStats().underruns.load());
+        mainStats.set("voice stream underruns", voiceTrack.getStats().underruns.load());
+        residency.beginFrame(AssetClass::Music);
+        auto music = loadedMusic.find(currentMusicPath);
+        if (music != loadedMusic.end()) {
+            residency.touch(music->second.residencyID); // never evict the theme that is playing
+        }
+    }
+
+    // Cooks every chapter theme ahead of time (--cook-audio), so first plays stream straight away.
+    void cookAllAudio() {
+        for (const Chapter& chapter : story.getChapters()) {
+            if (chapter.themeMusicPath.empty()) {
+                continue;
+            }
+            Uint64 start = SDL_GetPerformanceCounter();
+            std::string error;
+            std::string cookedPath = audioCache.cook(chapter.themeMusicPath, error);
+            double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+            if (cookedPath.empty()) {
+                logError() << "Failed to cook " << chapter.themeMusicPath << ": " << error;
+            } else {
+                std::cout << chapter.themeMusicPath << " -> " << cookedPath << " (" << ms << " ms)" << std::endl;
+            }
+        }
+    }
+
+    void insertMusic(const std::string& musicPath, Mix_Music* music) {
+        ResidencyManager::AssetID id = residency.registerAsset(AssetClass::Music, musicPath, ResidencyManager::fileBytes(musicPath), 0,
+                                                               [this, musicPath]() { freeMusic(musicPath); });
+        loadedMusic[musicPath] = {music, id};
+        residency.enforceBudget(AssetClass::Music);
+    }
+
+    void freeMusic(const std::string& musicPath) {
+        auto it = loadedMusic.find(musicPath);
+        if (it == loadedMusic.end()) {
+            return;
+        }
+        if (it->second.music == currentMusic) {
+            Mix_HaltMusic();
+            currentMusic = nullptr;
+        }
+        Mix_FreeMusic(it->second.music);
+        residency.unregisterAsset(it->second.residencyID);
+        loadedMusic.erase(it);
+    }
+
+    void handleInput() {
+        PAMPLEMOUSSE_TIME_SCOPE(mainStats, "input");
+        SDL_Event event;
+        while (pollEvent(event)) {
+            if (event.type == SDL_QUIT) {
+                isRunning = false;
+            } else if (event.type == SDL_KEYDOWN) {
+                if (event.key.keysym.sym == SDLK_F2) {
+                    std::cout << residency.report();
+                } else if (event.key.keysym.sym == SDLK_F3) {
+                    std::cout << mainStats.report();
+                    pendingRequests |= FrameDescription::ReportStats;
+                } else if (event.key.keysym.sym == SDLK_F4) {
+                    pendingRequests |= FrameDescription::ToggleOverlay;
+                } else if (event.key.keysym.sym == SDLK_F5) {
+                    if (options.saveGames && !navigator.inMenu()) {
+                        saveProgress(options.saveSlot);
+                    }
+                } else if (sequencer.dispatchKey(event.key.keysym.sym)) {
+                    // a sequence was waiting for it
+                } else if (event.key.keysym.sym == SDLK_1 || event.key.keysym.sym == SDLK_2) {
+                    followChoice(event.key.keysym.sym == SDLK_1 ? 0 : 1);
+                }
+            }
+        }
+    }
+
+    void followChoice(int choice) {
+        if (inTransition || !navigator.canChoose(choice)) {
+            return;
+        }
+        sequencer.start(choiceTransition(choice));
+    }
+
+    // Confirms the choice over a black screen, then opens the scene it leads to.
+    Sequence choiceTransition(int choice) {
+        inTransition = true;
+        {
+            TraceScope trace("scene transition", "scene");
+            pendingInputTicks = lastEventTicks;
+            playEffect(SoundEffectID::ChoiceConfirm);
+            voiceTrack.cancel();
+        }
+        co_await sequencer.delay(TransitionMs); // render() shows black frames meanwhile
+        navigator.choose(choice);
+        playEffect(SoundEffectID::PageTurn);
+        onSceneChanged();
+        inTransition = false;
+    }
+
+    void playEffect(SoundEffectID id) {
+        if (soundEffects.play(id) != -1) {
+            audioMonitor.markTrigger();
+        }
+    }
+
+    void renderBlackScreen() {
+        FrameDescription frame = {};
+        frame.kind = FrameDescription::Black;
+        frame.background = -1;
+        frame.text = -1;
+        frame.color = {0, 0, 0, 255};
+        submitFrame(frame);
+    }
+
+    // SDL_PollEvent with input replay and recording: replayed events due by this frame are
+    // queued first, and whatever the game consumes is logged.
+    bool pollEvent(SDL_Event& event) {
+        Uint32 frame = static_cast<Uint32>(frameIndex);
+        inputReplayer.pushDue(frame);
+        if (!SDL_PollEvent(&event)) {
+            return false;
+        }
+        lastEventTicks = SDL_GetPerformanceCounter();
+        inputRecorder.record(frame, event);
+        return true;
+    }
+
+    // Fast replays run without pacing.
+    void frameDelay(int ms) {
+        if (!inputReplayer.skipsDelays()) {
+            SDL_Delay(ms);
+        }
+    }
+
+    void renderTextInBox(const std::string& text, int x, int y, int width, int height) {
+        SDL_Color color = {255, 255, 255, 255};
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 200);
+        SDL_Rect textBox = {x, y, width, height};
+        SDL_RenderFillRect(renderer, &textBox);
+        renderText(text, x + 10, y + 10, width - 20);
+    }
+
+    void renderText(const std::string& text, int x, int y, int lineWidth) {
+        PAMPLEMOUSSE_TIME_SCOPE(stats, "text");
+        PAMPLEMOUSSE_ALLOCATION_SCOPE(Text);
+        const TextLayout& layout = layoutText(text, lineWidth);
+        for (const TextLine& line : layout.lines) {
+            if (!line.text.empty()) {
+                renderTextLine(line.text, x, y + line.yOffset);
+            }
+        }
+    }
+
+    // Word-wraps a text block to lineWidth pixels, caching the result per width and text.
+    const TextLayout& layoutText(const std::string& text, int lineWidth) {
+        std::unordered_map<std::string, TextLayout>& layouts = textLayouts[lineWidth];
+        auto it = layouts.find(text);
+        if (it != layouts.end()) {
+            return it->second;
+        }
+
+        PAMPLEMOUSSE_TIME_SCOPE(stats, "text wrap");
+        TraceScope trace("text layout", "text");
+        return layouts[text] = wrapText(font, text, lineWidth);
+    }
+
+    // Draws a line from its cached texture, rendering and uploading it the first time it is shown.
+    void renderTextLine(const std::string& text, int x, int y) {
+        auto it = lineTextures.find(text);
+        if (it == lineTextures.end()) {
+            PAMPLEMOUSSE_TIME_SCOPE(stats, "text line");
+            SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text.c_str(), {255, 255, 255, 255});
+            if (!surface) {
+                logError() << "Failed to create text surface: " << TTF_GetError();
+                return;
+            }
+            LineTexture line = {texturePool.createFromSurface(surface), surface->w, surface->h, 0, 0};
+            SDL_FreeSurface(surface);
+            if (!line.texture) {
+                return;
+            }
+            line.residencyID = residency.registerAsset(AssetClass::Text, text, 0, texturePool.residentBytes(line.texture));
+            it = lineTextures.emplace(text, line).first;
+        }
+        LineTexture& line = it->second;
+        line.lastUsed = renderedFrames;
+        SDL_Rect srcRect = {0, 0, line.w, line.h};
+        SDL_Rect dstRect = {x, y, line.w, line.h};
+        SDL_RenderCopy(renderer, line.texture, &srcRect, &dstRect);
+    }
+
+    // Hands back the textures of lines that have been off screen for a while.
+    void releaseIdleLineTextures() {
+        for (auto it = lineTextures.begin(); it != lineTextures.end();) {
+            if (renderedFrames - it->second.lastUsed > LineTextureIdleFrames) {
+                texturePool.release(it->second.texture);
+                residency.unregisterAsset(it->second.residencyID);
+                it = lineTextures.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // For text that changes every frame: rendered and uploaded each time, never cached.
+    void renderDynamicTextLine(const std::string& text, int x, int y) {
+        PAMPLEMOUSSE_TIME_SCOPE(stats, "text line");
+        SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text.c_str(), {255, 255, 255, 255});
+        if (!surface) {
+            logError() << "Failed to create text surface: " << TTF_GetError();
+            return;
+        }
+        SDL_Texture* texture = texturePool.uploadForFrame(surface);
+        SDL_Rect srcRect = {0, 0, surface->w, surface->h};
+        SDL_Rect dstRect = {x, y, surface->w, surface->h};
+        if (texture) {
+            SDL_RenderCopy(renderer, texture, &srcRect, &dstRect);
+        }
+        SDL_FreeSurface(surface);
+    }
+
+    void renderImage(const std::string& imagePath) {
+        PAMPLEMOUSSE_TIME_SCOPE(stats, "image");
+        const CachedImage* image = loadImage(imagePath);
+        if (!image) {
+            return;
+        }
+        SDL_Rect srcRect = {0, 0, image->w, image->h};
+        SDL_Rect dstRect = fitToWindow(image->w, image->h);
+        SDL_RenderCopy(renderer, image->texture, &srcRect, &dstRect);
+    }
+
+    // Returns the resident texture for an image, decoding and uploading it on first use.
+    const CachedImage* loadImage(const std::string& imagePath) {
+        auto it = imageCache.find(imagePath);
+        if (it != imageCache.end()) {
+            residency.touch(it->second.residencyID);
+            return &it->second;
+        }
+
+        PAMPLEMOUSSE_TIME_SCOPE(stats, "image load");
+        PAMPLEMOUSSE_ALLOCATION_SCOPE(Images);
+        TraceScope trace("image decode", "image");
+        DecodedImage decoded;
+        bool loaded = loadDisplayImage(diskCache, imagePath, yuvUploads && isJpegPath(imagePath), windowWidth, windowHeight, decoded);
+        metrics.imagesDecoded.fetch_add(1, std::memory_order_relaxed);
+        if (!loaded) {
+            return nullptr;
+        }
+        return insertImage(imagePath, decoded);
+    }
+
+    // Uploads decoded pixels into a pooled texture and makes it resident.
+    const CachedImage* insertImage(const std::string& imagePath, const DecodedImage& decoded) {
+        CachedImage image = {nullptr, decoded.w, decoded.h, 0};
+        if (decoded.isYUV()) {
+            image.texture = texturePool.createFromYUV(decoded);
+        } else {
+            SDL_Surface* view = decoded.createSurfaceView();
+            if (view) {
+                image.texture = texturePool.createFromSurface(view);
+                SDL_FreeSurface(view);
+            }
+        }
+        if (!image.texture) {
+            return nullptr;
+        }
+
+        image.residencyID = residency.registerAsset(AssetClass::Texture, imagePath, 0, texturePool.residentBytes(image.texture),
+                                                    [this, imagePath]() { evictImage(imagePath); });
+        CachedImage& cached = imageCache[imagePath] = image;
+        enforceResidencyBudgets();
+        return &cached;
+    }
+
+    void evictImage(const std::string& imagePath) {
+        auto it = imageCache.find(imagePath);
+        if (it == imageCache.end()) {
+            return;
+        }
+        texturePool.release(it->second.texture);
+        imageCache.erase(it);
+    }
+
+    void enforceResidencyBudgets() {
+        if (residency.enforceBudget(AssetClass::Texture) > 0) {
+            // Evicted textures went back to the pool; give their memory back for real.
+            texturePool.trimFree();
+        }
+    }
+
+    // Main-thread side of a scene change; the render side re-ranks images when it draws the scene.
+    void onSceneChanged() {
+        tracer().setContext(navigator.getSceneID(), navigator.getChapterID());
+        soundEffects.setAmbient(navigator.scene().ambientEffect);
+        playSceneVoice();
+        progress.enter(navigator.getChapterID(), navigator.getSceneID());
+        if (options.saveGames) {
+            saveProgress(SaveSlots::AutosaveSlot);
+        }
+    }
+
+    // Encodes progress and hands it to the writer job; the disk is never touched from here.
+    void saveProgress(int slot) {
+        PAMPLEMOUSSE_TIME_SCOPE(mainStats, "save");
+        saves.save(slot, progress);
+    }
+
+    // Maps a save at start-up. Missing or unusable saves are skipped quietly: the game starts at the menu.
+    void loadSave(int slot) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (!saves.load(slot, progress)) {
+            return;
+        }
+        resumePending = progress.chapterID >= 0;
+        double us = (SDL_GetPerformanceCounter() - start) * 1000000.0 / SDL_GetPerformanceFrequency();
+        std::cout << "Save: slot " << slot << " loaded in " << us << " us" << std::endl;
+    }
+
+    // Opens the scene the loaded save left off at. False, to start at the menu, if there is none
+    // or it was an ending.
+    bool resumeSavedScene() {
+        if (!resumePending) {
+            return false;
+        }
+        resumePending = false;
+        if (!navigator.selectChapter(progress.chapterID)) {
+            return false;
+        }
+        if (!navigator.goToScene(progress.sceneID) || navigator.atEnding()) {
+            navigator.returnToMenu();
+            return false;
+        }
+        playChapterMusic();
+        onSceneChanged();
+        return true;
+    }
+
+    // Plays the scene's line and prefetches the lines its choices lead to.
+    void playSceneVoice() {
+        const Chapter& chapter = navigator.chapter();
+        const ChoiceGraph& graph = navigator.graph();
+        int sceneID = navigator.getSceneID();
+        voiceTrack.play(chapter.scenes[sceneID].voicePath);
+        std::vector<std::string> nextClips;
+        for (int i = 0; i < graph.choiceCount(sceneID); ++i) {
+            int next = graph.next(sceneID, i);
+            if (next >= 0 && !chapter.scenes[next].voicePath.empty()) {
+                nextClips.push_back(chapter.scenes[next].voicePath);
+            }
+        }
+        voiceTrack.prefetch(nextClips);
+    }
+
+    // Re-ranks resident images by how many choices away their scenes are. Render side.
+    void updateSceneDistances(int chapterID, int sceneID) {
+        const std::vector<Scene>& scenes = story.chapter(chapterID).scenes;
+        std::vector<int> distance = story.graph(chapterID).distancesFrom(sceneID);
+        std::unordered_map<std::string, int> imageDistances;
+        for (size_t i = 0; i < scenes.size(); ++i) {
+            const std::string& path = scenes[i].imagePath;
+            if (path.empty() || distance[i] == ChoiceGraph::Unreachable) {
+                continue;
+            }
+            auto it = imageDistances.find(path);
+            if (it == imageDistances.end() || distance[i] < it->second) {
+                imageDistances[path] = distance[i];
+            }
+        }
+        residency.setGraphDistances(imageDistances);
+    }
+
+    // Scales an image to the window width (landscape) or height (portrait), centred, keeping its aspect ratio.
+    SDL_Rect fitToWindow(int imgW, int imgH) {
+        return fitRect(imgW, imgH, windowWidth, windowHeight);
+    }
+
+    void evictAllImages() {
+        for (auto& entry : imageCache) {
+            texturePool.release(entry.second.texture);
+            residency.unregisterAsset(entry.second.residencyID);
+        }
+        imageCache.clear();
+    }
+
+    std::vector<std::string> uniqueImagePaths() const {
+        std::vector<std::string> paths;
+        for (const Chapter& chapter : story.getChapters()) {
+            for (const Scene& scene : chapter.scenes) {
+                if (!scene.imagePath.empty() && std::find(paths.begin(), paths.end(), scene.imagePath) == paths.end()) {
+                    paths.push_back(scene.imagePath);
+                }
+            }
+        }
+        return paths;
+    }
+
+    // Loads and uploads every scene image with an empty disk cache, then again with a warm one.
+    void runImageCacheBenchmark() {
+        if (!diskCache.isEnabled()) {
+            logError() << "Image cache benchmark needs the disk cache (--image-cache-mb > 0)";
+            return;
+        }
+        std::vector<std::string> paths = uniqueImagePaths();
+        diskCache.clear();
+        double coldMs = timeImageLoads(paths);
+        double warmMs = timeImageLoads(paths);
+        std::cout << "Image cache benchmark: " << paths.size() << " images, cold " << coldMs << " ms, warm " << warmMs
+                  << " ms (" << (warmMs > 0 ? coldMs / warmMs : 0) << "x), cache at " << diskCache.getDirectory() << std::endl;
+    }
+
+    double timeImageLoads(const std::vector<std::string>& paths) {
+        evictAllImages();
+        texturePool.trimFree();
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (const std::string& path : paths) {
+            loadImage(path);
+        }
+        Uint64 end = SDL_GetPerformanceCounter();
+        return (end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    }
+
+    // Hands a frame to the render thread, or draws it here without one. Main thread.
+    void submitFrame(FrameDescription frame) {
+        frame.requests |= pendingRequests;
+        frame.inputTicks = pendingInputTicks;
+        frame.serial = frameIndex++; // counted even when dropped, so replays line up with recordings
+        if (!options.renderThread) {
+            drawFrame(frame);
+        } else if (!renderThread.submit(frame)) {
+            mainStats.count("frames dropped"); // requests and input wait for the next frame
+            return;
+        }
+        pendingRequests = 0;
+        pendingInputTicks = 0;
+        if (metricsServer.isRunning()) {
+            publishAudioMetrics();
+        }
+    }
+
+    FrameDescription sceneFrame() const {
+        FrameDescription frame = {};
+        frame.kind = FrameDescription::Scene;
+        frame.chapterID = static_cast<Sint16>(navigator.getChapterID());
+        frame.sceneID = static_cast<Sint16>(navigator.getSceneID());
+        const SceneFrameIDs& ids = sceneFrames[navigator.getChapterID()][navigator.getSceneID()];
+        frame.background = ids.background;
+        frame.text = ids.text;
+        frame.color = navigator.scene().bgColor;
+        return frame;
+    }
+
+    // Draws one frame. On the render thread, or inline without one.
+    void drawFrame(const FrameDescription& frame) {
+        PAMPLEMOUSSE_ALLOCATION_SCOPE(Render);
+        if (frame.requests & FrameDescription::ReportStats) {
+            std::cout << stats.report();
+        }
+        if (frame.requests & FrameDescription::ToggleOverlay) {
+            showOverlay = !showOverlay;
+        }
+        if (frame.kind == FrameDescription::Menu && lastDrawnKind != FrameDescription::Menu) {
+            startImageWarmup();
+        } else if (frame.kind != FrameDescription::Menu && lastDrawnKind == FrameDescription::Menu) {
+            finishImageWarmup();
+        }
+        lastDrawnKind = frame.kind;
+        if (frame.kind == FrameDescription::Scene && (frame.chapterID != drawnChapter || frame.sceneID != drawnScene)) {
+            drawnChapter = frame.chapterID;
+            drawnScene = frame.sceneID;
+            updateSceneDistances(drawnChapter, drawnScene);
+            enforceResidencyBudgets();
+        }
+
+        SDL_SetRenderDrawColor(renderer, frame.color.r, frame.color.g, frame.color.b, frame.color.a);
+        SDL_RenderClear(renderer);
+        if (frame.kind == FrameDescription::Menu) {
+            drawWelcomeScreen();
+        } else if (frame.kind == FrameDescription::Scene) {
+            if (frame.background >= 0) {
+                renderImage(backgroundPaths[frame.background]);
+            }
+            if (frame.text >= 0) {
+                renderTextInBox(*textBoxes[frame.text], 50, 400, 700, 180);
+            }
+        }
+        presentFrame(frame);
+        if (frame.kind == FrameDescription::Menu) {
+            pumpImageWarmup();
+        }
+    }
+
+    // Presents the frame and hands the frame's pooled textures back for reuse.
+    void presentFrame(const FrameDescription& frame) {
+        if (showOverlay) {
+            PAMPLEMOUSSE_ALLOCATION_SCOPE(Overlay);
+            renderOverlay();
+        }
+        {
+            PAMPLEMOUSSE_TIME_SCOPE(stats, "present");
+            SDL_RenderPresent(renderer);
+        }
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (lastPresent) {
+            stats.add("frame", ticksToMs(now - lastPresent));
+        }
+        lastPresent = now;
+        if (frame.inputTicks) {
+            // Without vsync the present returning is as close to the photons as SDL lets us see.
+            stats.add("input to photon", ticksToMs(now - frame.inputTicks));
+        }
+        if (startup.markFirstFrame()) {
+            stats.add("time to first frame", startup.timeToFirstFrameMs());
+            metrics.timeToFirstFrameMs.store(startup.timeToFirstFrameMs(), std::memory_order_relaxed);
+            std::cout << startup.report();
+        }
+        if (metricsServer.isRunning()) {
+            publishMetrics();
+        }
+        texturePool.endFrame();
+        if (++renderedFrames % LineTextureIdleFrames == 0) {
+            releaseIdleLineTextures();
+        }
+        residency.beginFrame(AssetClass::Texture);
+    }
+
+    // Copies this frame's render counters into the scrape-able metrics. Percentiles sort the
+    // frame window, so they are refreshed every MetricsPercentileFrames frames only.
+    void publishMetrics() {
+        static const int MetricsPercentileFrames = 10;
+        metrics.frames.fetch_add(1, std::memory_order_relaxed);
+        const RollingStat* frameTimes = stats.find("frame");
+        if (frameTimes && renderedFrames % MetricsPercentileFrames == 0) {
+            metrics.frameMsP50.store(frameTimes->percentile(0.5), std::memory_order_relaxed);
+            metrics.frameMsP99.store(frameTimes->percentile(0.99), std::memory_order_relaxed);
+            metrics.frameMsMax.store(frameTimes->max(), std::memory_order_relaxed);
+            const RollingStat* inputToPhoton = stats.find("input to photon");
+            if (inputToPhoton) {
+                metrics.inputToPhotonMsP50.store(inputToPhoton->percentile(0.5), std::memory_order_relaxed);
+                metrics.inputToPhotonMsP99.store(inputToPhoton->percentile(0.99), std::memory_order_relaxed);
+            }
+        }
+        const TexturePool::Stats& pool = texturePool.getStats();
+        metrics.texturePoolHits.store(pool.hits, std::memory_order_relaxed);
+        metrics.texturePoolMisses.store(pool.misses, std::memory_order_relaxed);
+        metrics.textureBytesResident.store(pool.bytesResident, std::memory_order_relaxed);
+        metrics.diskCacheHits.store(diskCache.getStats().hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        metrics.diskCacheMisses.store(diskCache.getStats().misses.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // The audio counters, from the main thread.
+    void publishAudioMetrics() {
+        metrics.musicUnderruns.store(streamMixer.getStats().underruns.load(), std::memory_order_relaxed);
+        metrics.voiceUnderruns.store(voiceTrack.getStats().underruns.load(), std::memory_order_relaxed);
+        metrics.audioLateCallbacks.store(mainStats.counterSlot("audio late callbacks"), std::memory_order_relaxed);
+    }
+
+    // Frame timing, per-stage costs and cache hit rates, drawn over the frame (F4).
+    void renderOverlay() {
+        const TexturePool::Stats& pool = texturePool.getStats();
+        const ImageDiskCache::Stats& disk = diskCache.getStats();
+        char lines[5][128];
+        snprintf(lines[0], sizeof(lines[0]), "frame %s", formatStat("frame").c_str());
+        snprintf(lines[1], sizeof(lines[1]), "image load %s", formatStat("image load").c_str());
+        snprintf(lines[2], sizeof(lines[2]), "wrap %s  line %s", formatStat("text wrap").c_str(), formatStat("text line").c_str());
+        snprintf(lines[3], sizeof(lines[3]), "present %s  input to photon %s", formatStat("present").c_str(), formatStat("input to photon").c_str());
+        snprintf(lines[4], sizeof(lines[4]), "textures %d%% hit  disk cache %d%% hit", hitRate(pool.hits, pool.misses),
+                 hitRate(disk.hits.load(), disk.misses.load()));
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+        SDL_Rect box = {0, 0, 520, 10 + 30 * 5};
+        SDL_RenderFillRect(renderer, &box);
+        for (int i = 0; i < 5; ++i) {
+            renderDynamicTextLine(lines[i], 10, 5 + 30 * i);
+        }
+    }
+
+    // "avg/p99 ms" for a timing series, or "-" before it has samples.
+    std::string formatStat(const char* name) {
+        const RollingStat& stat = stats.series(name);
+        if (stat.count() == 0) {
+            return "-";
+        }
+        char text[48];
+        snprintf(text, sizeof(text), "%.1f/%.1f ms", stat.average(), stat.percentile(0.99));
+        return text;
+    }
+
+    static int hitRate(Uint64 hits, Uint64 misses) {
+        return hits + misses ? static_cast<int>(hits * 100 / (hits + misses)) : 0;
+    }
+
+    void render() {
+        if (inTransition) {
+            renderBlackScreen();
+            return;
+        }
+        if (!navigator.inMenu() && navigator.atEnding()) {
+            navigator.returnToMenu();
+            openMenu();
+        }
+        if (navigator.inMenu()) {
+            // Render Welcome Screen
+            renderWelcomeScreen();
+            return;
+        }
+        submitFrame(sceneFrame());
+    }
+
+    void renderWelcomeScreen() {
+        FrameDescription frame = {};
+        frame.kind = FrameDescription::Menu;
+        frame.background = -1;
+        frame.text = -1;
+        frame.color = {0, 0, 0, 255}; // black background
+        submitFrame(frame);
+    }
+
+    // The menu over a cleared frame. Render side.
+    void drawWelcomeScreen() {
+        // Strings built once, not per frame
+        static const std::string festiveMessage = "JOYEUX NOEL";
+        static const std::string description = "Le jeux dont tu es l'héroïne.";
+        static const std::string welcome = "Welcome! Select a Chapter:";
+        static const std::string instructions = "Appuie une fois sur le nombre qui correspond à ton choix.";
+        static const std::string heartfelt = "Je t'aime <3";
+
+        // Render a festive message at the top
+        renderText(festiveMessage, 200, 50, 400);
+
+        // Render the game description
+        renderText(description, 100, 100, 600); 
+
+        // Render the welcome message
+        renderText(welcome, 100, 150, 600);
+
+        // Render the list of chapters
+        for (int i = 0; i < menuLabels.size(); ++i) {
+            renderText(menuLabels[i], 100, 200 + (i * 40), 600); 
+        }
+
+        // Render instructions for the player
+        renderText(instructions, 100, 200 + (story.chapterCount() * 40) + 20, 600); 
+
+        // Render a heartfelt message at the bottom
+        renderText(heartfelt, 300, 400, 200);
+    }
+
+
+    // While the menu is up, decode the opening scenes of every chapter on all cores and wrap the
+    // opening text, so picking a chapter shows a fully resident first frame. Render side; the
+    // themes warm up on the main thread in startMusicWarmup().
+    void startImageWarmup() {
+        int winW = windowWidth, winH = windowHeight;
+        std::vector<WarmupBatch::Task> tasks;
+        std::vector<std::string> queuedImages;
+        for (int chapterID = 0; chapterID < story.chapterCount(); ++chapterID) {
+            const Chapter& chapter = story.chapter(chapterID);
+            std::vector<int> distance = story.graph(chapterID).distancesFrom(0);
+            for (size_t i = 0; i < chapter.scenes.size(); ++i) {
+                if (distance[i] > options.warmupDepth) {
+                    continue;
+                }
+                const Scene& scene = chapter.scenes[i];
+                pendingLayouts.push_back({scene.textBox, 680});
+                const std::string& path = scene.imagePath;
+                if (path.empty() || imageCache.count(path) ||
+                    std::find(queuedImages.begin(), queuedImages.end(), path) != queuedImages.end()) {
+                    continue;
+                }
+                queuedImages.push_back(path);
+                bool wantYUV = yuvUploads && isJpegPath(path);
+                int sceneID = scene.id;
+                metrics.decodeQueueDepth.fetch_add(1, std::memory_order_relaxed);
+                tasks.push_back([this, path, wantYUV, winW, winH, sceneID, chapterID]() -> WarmupBatch::Continuation {
+                    TraceScope trace("image decode", "image", sceneID, chapterID);
+                    std::shared_ptr<DecodedImage> decoded = std::make_shared<DecodedImage>();
+                    bool loaded = loadDisplayImage(diskCache, path, wantYUV, winW, winH, *decoded);
+                    metrics.imagesDecoded.fetch_add(1, std::memory_order_relaxed);
+                    metrics.decodeQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+                    if (!loaded) {
+                        return nullptr;
+                    }
+                    return [this, path, decoded]() {
+                        if (!imageCache.count(path)) {
+                            insertImage(path, *decoded);
+                        }
+                    };
+                });
+            }
+        }
+        warmupStart = SDL_GetPerformanceCounter();
+        warmup.run(std::move(tasks));
+    }
+
+    // Uploads whatever the workers finished and wraps a few text blocks. Render side, after each menu frame.
+    void pumpImageWarmup() {
+        warmup.pump();
+        for (int i = 0; i < 4 && !pendingLayouts.empty(); ++i) {
+            layoutText(pendingLayouts.back().first, pendingLayouts.back().second);
+            pendingLayouts.pop_back();
+        }
+    }
+
+    void finishImageWarmup() {
+        bool wasRunning = warmup.isRunning();
+        warmup.finish();
+        while (!pendingLayouts.empty()) {
+            pumpImageWarmup();
+        }
+        if (wasRunning) {
+            double ms = (SDL_GetPerformanceCounter() - warmupStart) * 1000.0 / SDL_GetPerformanceFrequency();
+            std::cout << "Warm-up: " << imageCache.size() << " images ready after " << ms << " ms" << std::endl;
+        }
+    }
+
+    // Opens or cooks every chapter theme on workers while the menu is up. Main thread.
+    void startMusicWarmup() {
+        std::vector<WarmupBatch::Task> tasks;
+        for (const Chapter& chapter : story.getChapters()) {
+            const std::string musicPath = chapter.themeMusicPath;
+            if (musicPath.empty() || loadedMusic.count(musicPath) || cookedThemes.count(musicPath)) {
+                continue;
+            }
+            tasks.push_back([this, musicPath]() -> WarmupBatch::Continuation {
+                // Cooking decodes the whole theme once; the Mix_LoadMUS fallback only parses the stream headers.
+                MusicLoad loaded = prepareMusic(musicPath);
+                if (loaded.cookedPath.empty() && !loaded.music) {
+                    return nullptr;
+                }
+                return [this, musicPath, loaded]() { insertPreparedMusic(musicPath, loaded); };
+            });
+        }
+        musicWarmupStart = SDL_GetPerformanceCounter();
+        musicWarmup.run(std::move(tasks), JobPriority::Low); // behind the images the first frame needs
+    }
+
+    void finishMusicWarmup() {
+        bool wasRunning = musicWarmup.isRunning();
+        musicWarmup.finish();
+        if (wasRunning) {
+            double ms = (SDL_GetPerformanceCounter() - musicWarmupStart) * 1000.0 / SDL_GetPerformanceFrequency();
+            std::cout << "Warm-up: " << loadedMusic.size() + cookedThemes.size() << " themes ready after " << ms << " ms" << std::endl;
+        }
+    }
+
+    void openMenu() {
+        if (!menuOpen) {
+            sequencer.start(chapterMenu());
+        }
+    }
+
+    // Warms up the themes while waiting for a chapter key, then starts that chapter.
+    Sequence chapterMenu() {
+        menuOpen = true;
+        std::vector<std::string> openingClips;
+        for (const Chapter& chapter : story.getChapters()) {
+            if (!chapter.scenes.empty() && !chapter.scenes[0].voicePath.empty()) {
+                openingClips.push_back(chapter.scenes[0].voicePath);
+            }
+        }
+        voiceTrack.prefetch(openingClips);
+        startMusicWarmup(); // the images warm up on the render side while it draws the menu
+        int selectedChapter = -1;
+        while (selectedChapter < 0 || selectedChapter >= story.chapterCount()) {
+            int key = co_await sequencer.keyPress();
+            selectedChapter = key == SDLK_1 ? 0 : key == SDLK_2 ? 1 : -1;
+        }
+        Uint64 keyTicks = lastEventTicks;
+        playEffect(SoundEffectID::MenuSelect);
+        // The chosen theme loads on its own; only wait for the ones already being cooked.
+        musicWarmup.cancel();
+        co_await sequencer.until([this]() { return musicWarmup.isDone(); });
+        finishMusicWarmup();
+        pendingInputTicks = keyTicks;
+        navigator.selectChapter(selectedChapter);
+        playChapterMusic();
+        onSceneChanged();
+        menuOpen = false;
+    }
+
+    int getChapterCount() const { return story.chapterCount(); }
+    Uint64 getFrameCount() const { return frameIndex; }
+    const StatsRegistry& getStats() const { return stats; } // render side: read it after clean() or without a render thread
+    const StatsRegistry& getMainStats() const { return mainStats; }
+    const Chapter& getChapter(int chapterIndex) const { return story.chapter(chapterIndex); }
+    const Story& getStory() const { return story; }
+
+    // Jumps to a scene of the current chapter as if a choice had led there.
+    void goToScene(int sceneID) {
+        if (navigator.goToScene(sceneID)) {
+            onSceneChanged();
+        }
+    }
+
+    void startChapter(int chapterIndex) {
+        if (!navigator.selectChapter(chapterIndex)) {
+            return;
+        }
+        if (menuOpen) {
+            sequencer.clear(); // the chapter was picked from outside the menu
+            menuOpen = false;
+            inTransition = false;
+        }
+        playChapterMusic();
+        onSceneChanged();
+    }
+
+    // Tries buffer sizes from small to large and saves the smallest stable one for later runs (--calibrate-audio).
+    void calibrateAudioBuffer() {
+        static const int candidates[] = {256, 512, 1024, 2048, 4096};
+        std::vector<AudioMonitor::Calibration> results;
+        int best = audioMonitor.calibrate(std::vector<int>(std::begin(candidates), std::end(candidates)), 1500, audioBufferFrames, results);
+        for (const AudioMonitor::Calibration& result : results) {
+            std::cout << result.bufferFrames << " frames: " << result.callbacks << " callbacks, " << result.lateCallbacks
+                      << " late, p99 jitter " << result.p99JitterMs << " ms" << (result.stable ? "" : " (unstable)") << std::endl;
+        }
+        if (best == 0) {
+            std::cout << "No stable buffer size found; keeping " << audioBufferFrames << " frames" << std::endl;
+            return;
+        }
+        std::cout << "Using " << best << " frames (" << best * 1000.0 / audioCache.getFrequency() << " ms)";
+        if (AudioMonitor::saveCalibratedBufferFrames(best)) {
+            std::cout << " from now on" << std::endl;
+        } else {
+            std::cout << ", but it could not be saved" << std::endl;
+        }
+    }
+
+    // Exit status for --sfx-stress: 0, 1 if a trigger allocated, StressSkipped without the effect files.
+    int runSoundEffectStress() {
+        if (!soundEffects.canStress()) {
+            logWarning() << "SFX stress skipped: the pool effects did not load";
+            return StressSkipped;
+        }
+        return soundEffects.runStressTest(options.sfxStressSeconds, StressTriggersPerSecond) ? 0 : 1;
+    }
+
+    void printTexturePoolStats() {
+        const TexturePool::Stats& stats = texturePool.getStats();
+        std::cout << "Texture pool: " << stats.hits << " hits, " << stats.misses << " misses, "
+                  << stats.texturesResident << " textures (" << stats.bytesResident << " bytes) resident, "
+                  << stats.lastFrameMisses << " created last frame" << std::endl;
+    }
+
+    // Reports on and frees everything the renderer owns, then the renderer. Render side.
+    void releaseRenderResources() {
+        warmup.cancel();
+        warmup.finish();
+        if (!renderer) {
+            return;
+        }
+        std::cout << stats.report();
+        printTexturePoolStats();
+        evictAllImages();
+        for (auto& entry : lineTextures) {
+            texturePool.release(entry.second.texture);
+            residency.unregisterAsset(entry.second.residencyID);
+        }
+        lineTextures.clear();
+        texturePool.clear();
+        SDL_DestroyRenderer(renderer);
+        renderer = nullptr;
+    }
+
+    void clean() {
+        metricsServer.stop();
+        inputRecorder.stop();
+        std::cout << residency.report(); // while everything is still loaded
+        if (options.renderThread) {
+            renderThread.stop(); // draws what is queued, then releases the renderer on its thread
+        } else {
+            releaseRenderResources();
+        }
+        sequencer.clear();
+        musicWarmup.cancel();
+        musicWarmup.finish();
+        std::cout << mainStats.report();
+        const StreamMixer::Stats& streamStats = streamMixer.getStats();
+        std::cout << "Music stream: " << streamStats.callbacks.load() << " callbacks, " << streamStats.underruns.load() << " underruns" << std::endl;
+        const StreamMixer::Stats& voiceStats = voiceTrack.getStats();
+        std::cout << "Voice-over: " << voiceStats.underruns.load() << " underruns, " << voiceTrack.prefetchedBytes() << " bytes prefetched" << std::endl;
+        const SoundEffects::Stats& effectStats = soundEffects.getStats();
+        std::cout << "Sound effects: " << effectStats.triggers << " triggers, " << effectStats.steals << " stolen, " << effectStats.dropped << " dropped" << std::endl;
+        if (musicLoad.valid()) {
+            MusicLoad loaded = musicLoad.get();
+            if (loaded.music) {
+                Mix_FreeMusic(loaded.music);
+            }
+        }
+        tracer().stop();
+        streamMixer.uninstall();
+        audioMonitor.uninstall();
+        voiceTrack.shutdown();
+        saves.flush();
+        const SaveSlots::Stats& saveStats = saves.getStats();
+        std::cout << "Saves: " << saveStats.written.load() << " written, " << saveStats.superseded.load() << " superseded, "
+                  << saveStats.failed.load() << " failed" << std::endl;
+        const JobSystem::Stats& jobStats = jobs().getStats();
+        std::cout << "Jobs: " << jobStats.executed.load() << " run on " << jobs().threadCount() << " threads, " << jobStats.stolen.load()
+                  << " stolen, " << jobStats.cancelled.load() << " cancelled" << std::endl;
+        jobs().stop(); // nothing still queued touches the audio device once it closes
+        soundEffects.clear();
+        audioCache.freeChunks();
+        Mix_HaltMusic();
+        while (!loadedMusic.empty()) {
+            freeMusic(loadedMusic.begin()->first); // Free the music
+        }
+        Mix_CloseAudio();
+        TTF_CloseFont(font);
+        SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+    }
+
+#ifdef PAMPLEMOUSSE_TRACK_ALLOCATIONS
+    // Records what the frame allocated. Once a scene has been on screen for SteadyStateFrames,
+    // frames should not allocate at all; the first one that does on each scene is reported.
+    void checkFrameAllocations() {
+        AllocationSnapshot now = allocations().snapshot();
+        AllocationSnapshot frame = now - lastFrameAllocations;
+        lastFrameAllocations = now;
+        if (navigator.getSceneID() != lastFrameScene || navigator.getChapterID() != lastFrameChapter) {
+            lastFrameScene = navigator.getSceneID();
+            lastFrameChapter = navigator.getChapterID();
+            steadyFrames = 0;
+            allocationReported = false;
+        }
+        mainStats.add("frame allocations", static_cast<double>(frame.totalCount()));
+        mainStats.add("frame allocated KiB", frame.totalBytes() / 1024.0);
+        if (++steadyFrames <= SteadyStateFrames || frame.totalCount() == 0) {
+            return;
+        }
+        mainStats.count("steady frames allocating");
+        if (!allocationReported) {
+            logWarning() << "Frame allocated " << frame.totalCount() << " times on scene " << navigator.getSceneID() << " after settling: "
+                      << frame.describe();
+            allocationReported = true;
+        }
+    }
+#endif
+
+    void run() {
+        if (!resumeSavedScene()) {
+            openMenu();
+        }
+        int frameMs = 0;
+        while (isRunning) {
+            TraceScope frame("frame", "main loop");
+            {
+                TraceScope trace("input", "main loop");
+                PAMPLEMOUSSE_ALLOCATION_SCOPE(Input);
+                handleInput();
+            }
+            {
+                TraceScope trace("audio update", "main loop");
+                PAMPLEMOUSSE_ALLOCATION_SCOPE(Audio);
+                updateAudio();
+            }
+            {
+                TraceScope trace("sequences", "main loop");
+                sequencer.advance(static_cast<std::uint32_t>(frameMs));
+            }
+            {
+                TraceScope trace("render", "main loop");
+                render(); // submits the frame; drawing is scoped to Render in drawFrame()
+            }
+#ifdef PAMPLEMOUSSE_TRACK_ALLOCATIONS
+            checkFrameAllocations();
+#endif
+            TraceScope trace("sleep", "main loop");
+            frameMs = navigator.inMenu() ? MenuFrameMs : SceneFrameMs;
+            frameDelay(frameMs);
+        }
+    }
+};
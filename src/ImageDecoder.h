@@ -0,0 +1,306 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CacheFiles.h"
+#include "Log.h"
+
+#ifdef PAMPLEMOUSSE_HAVE_LIBJPEG
+#include <csetjmp>
+#include <jpeglib.h>
+#endif
+
+// Decoded pixels ready for upload: packed ARGB8888, or planar 4:2:0 laid out the way
+// SDL_PIXELFORMAT_IYUV expects (Y plane, then U, then V, luma pitch == w).
+// The pixels may live in a heap buffer, an SDL_Surface or a memory-mapped cache file;
+// storage keeps whichever it is alive.
+struct DecodedImage {
+    Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+    int w = 0;
+    int h = 0;
+    int pitch = 0;
+    const Uint8* pixels = nullptr;
+    std::shared_ptr<void> storage;
+
+    bool isYUV() const { return format == SDL_PIXELFORMAT_IYUV; }
+    int chromaWidth() const { return (w + 1) / 2; }
+    int chromaHeight() const { return (h + 1) / 2; }
+    const Uint8* yPlane() const { return pixels; }
+    const Uint8* uPlane() const { return pixels + static_cast<size_t>(pitch) * h; }
+    const Uint8* vPlane() const { return uPlane() + static_cast<size_t>(chromaWidth()) * chromaHeight(); }
+
+    size_t byteSize() const {
+        if (isYUV()) {
+            return static_cast<size_t>(pitch) * h + 2 * static_cast<size_t>(chromaWidth()) * chromaHeight();
+        }
+        return static_cast<size_t>(pitch) * h;
+    }
+
+    // Wraps packed pixels in a surface without copying; the surface must not outlive this image.
+    SDL_Surface* createSurfaceView() const {
+        return SDL_CreateRGBSurfaceWithFormatFrom(const_cast<Uint8*>(pixels), w, h, SDL_BITSPERPIXEL(format), pitch, format);
+    }
+
+    // Allocates owned storage for an image of the given format and size.
+    void allocate(Uint32 pixelFormat, int width, int height) {
+        format = pixelFormat;
+        w = width;
+        h = height;
+        pitch = isYUV() ? width : width * SDL_BYTESPERPIXEL(pixelFormat);
+        std::shared_ptr<std::vector<Uint8>> buffer = std::make_shared<std::vector<Uint8>>(byteSize());
+        pixels = buffer->data();
+        storage = buffer;
+    }
+
+    Uint8* writablePixels() { return const_cast<Uint8*>(pixels); }
+};
+
+inline bool isJpegPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == "jpg" || extension == "jpeg";
+}
+
+// Scales an image to the box width (landscape) or height (portrait), centred, keeping its aspect ratio.
+inline SDL_Rect fitRect(int imgW, int imgH, int boxW, int boxH) {
+    float aspectRatio = static_cast<float>(imgW) / imgH;
+    SDL_Rect dstRect;
+    if (imgW > imgH) {
+        dstRect.w = boxW;
+        dstRect.h = static_cast<int>(boxW / aspectRatio);
+    } else {
+        dstRect.h = boxH;
+        dstRect.w = static_cast<int>(boxH * aspectRatio);
+    }
+    dstRect.x = (boxW - dstRect.w) / 2;
+    dstRect.y = (boxH - dstRect.h) / 2;
+    return dstRect;
+}
+
+// Size an image is stored at for a given display box: its fitted size, but never upscaled.
+inline void displaySize(int imgW, int imgH, int boxW, int boxH, int& outW, int& outH) {
+    SDL_Rect fit = fitRect(imgW, imgH, boxW, boxH);
+    if (fit.w >= imgW || fit.h >= imgH || fit.w <= 0 || fit.h <= 0) {
+        outW = imgW;
+        outH = imgH;
+    } else {
+        outW = fit.w;
+        outH = fit.h;
+    }
+}
+
+// Bilinear resample of one 8-bit plane.
+inline void scalePlane(const Uint8* src, int srcW, int srcH, int srcPitch, Uint8* dst, int dstW, int dstH, int dstPitch) {
+    for (int y = 0; y < dstH; ++y) {
+        float fy = std::max(0.0f, (y + 0.5f) * srcH / dstH - 0.5f);
+        int y0 = std::min(static_cast<int>(fy), srcH - 1);
+        int y1 = std::min(y0 + 1, srcH - 1);
+        float wy = fy - y0;
+        const Uint8* row0 = src + static_cast<size_t>(y0) * srcPitch;
+        const Uint8* row1 = src + static_cast<size_t>(y1) * srcPitch;
+        Uint8* out = dst + static_cast<size_t>(y) * dstPitch;
+        for (int x = 0; x < dstW; ++x) {
+            float fx = std::max(0.0f, (x + 0.5f) * srcW / dstW - 0.5f);
+            int x0 = std::min(static_cast<int>(fx), srcW - 1);
+            int x1 = std::min(x0 + 1, srcW - 1);
+            float wx = fx - x0;
+            float top = row0[x0] + (row0[x1] - row0[x0]) * wx;
+            float bottom = row1[x0] + (row1[x1] - row1[x0]) * wx;
+            out[x] = static_cast<Uint8>(top + (bottom - top) * wy + 0.5f);
+        }
+    }
+}
+
+#ifdef PAMPLEMOUSSE_HAVE_LIBJPEG
+namespace detail {
+    struct JpegErrorManager {
+        jpeg_error_mgr base;
+        jmp_buf jump;
+        char message[JMSG_LENGTH_MAX];
+    };
+
+    inline void jpegErrorExit(j_common_ptr info) {
+        JpegErrorManager* manager = reinterpret_cast<JpegErrorManager*>(info->err);
+        (*info->err->format_message)(info, manager->message);
+        longjmp(manager->jump, 1);
+    }
+
+    // Reads the JPEG's native YCbCr samples and subsamples chroma 2x2 into IYUV planes.
+    // DCT scaling gets the decode close to the display size for free.
+    // Kept free of objects with destructors so the longjmp error path stays well-defined.
+    inline bool readJpegYCbCr(const Uint8* data, size_t size, int boxW, int boxH, DecodedImage& out, JpegErrorManager& errors) {
+        jpeg_decompress_struct info;
+        info.err = jpeg_std_error(&errors.base);
+        errors.base.error_exit = jpegErrorExit;
+        if (setjmp(errors.jump)) {
+            jpeg_destroy_decompress(&info);
+            return false;
+        }
+
+        jpeg_create_decompress(&info);
+        jpeg_mem_src(&info, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+        jpeg_read_header(&info, TRUE);
+        if (info.num_components != 3) {
+            jpeg_destroy_decompress(&info);
+            snprintf(errors.message, sizeof(errors.message), "not a three-component JPEG");
+            return false;
+        }
+        info.out_color_space = JCS_YCbCr;
+        int targetW, targetH;
+        displaySize(static_cast<int>(info.image_width), static_cast<int>(info.image_height), boxW, boxH, targetW, targetH);
+        info.scale_denom = 8;
+        for (info.scale_num = 1; info.scale_num < 8; ++info.scale_num) {
+            if (info.image_width * info.scale_num / 8 >= static_cast<unsigned>(targetW) &&
+                info.image_height * info.scale_num / 8 >= static_cast<unsigned>(targetH)) {
+                break;
+            }
+        }
+        jpeg_start_decompress(&info);
+
+        out.allocate(SDL_PIXELFORMAT_IYUV, static_cast<int>(info.output_width), static_cast<int>(info.output_height));
+        int chromaW = out.chromaWidth();
+        Uint8* yPlane = out.writablePixels();
+        Uint8* uPlane = yPlane + static_cast<size_t>(out.w) * out.h;
+        Uint8* vPlane = uPlane + static_cast<size_t>(chromaW) * out.chromaHeight();
+
+        // Two interleaved YCbCr rows at a time, so each chroma sample averages a 2x2 block.
+        JSAMPARRAY rows = (*info.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&info), JPOOL_IMAGE, info.output_width * 3, 2);
+        while (info.output_scanline < info.output_height) {
+            int row = static_cast<int>(info.output_scanline);
+            jpeg_read_scanlines(&info, rows, 1);
+            if (info.output_scanline < info.output_height) {
+                jpeg_read_scanlines(&info, rows + 1, 1);
+            } else {
+                std::copy(rows[0], rows[0] + info.output_width * 3, rows[1]);
+            }
+            int pairRows = row + 1 < out.h ? 2 : 1;
+            for (int r = 0; r < pairRows; ++r) {
+                for (int x = 0; x < out.w; ++x) {
+                    yPlane[static_cast<size_t>(row + r) * out.w + x] = rows[r][x * 3];
+                }
+            }
+            for (int cx = 0; cx < chromaW; ++cx) {
+                int x0 = cx * 2;
+                int x1 = x0 + 1 < out.w ? x0 + 1 : x0;
+                int cb = rows[0][x0 * 3 + 1] + rows[0][x1 * 3 + 1] + rows[1][x0 * 3 + 1] + rows[1][x1 * 3 + 1];
+                int cr = rows[0][x0 * 3 + 2] + rows[0][x1 * 3 + 2] + rows[1][x0 * 3 + 2] + rows[1][x1 * 3 + 2];
+                size_t index = static_cast<size_t>(row / 2) * chromaW + cx;
+                uPlane[index] = static_cast<Uint8>((cb + 2) / 4);
+                vPlane[index] = static_cast<Uint8>((cr + 2) / 4);
+            }
+        }
+
+        jpeg_finish_decompress(&info);
+        jpeg_destroy_decompress(&info);
+        return true;
+    }
+}
+#endif
+
+// Scales IYUV planes down to the display size for the box.
+inline void scaleYUVToDisplay(DecodedImage& image, int boxW, int boxH) {
+    int targetW, targetH;
+    displaySize(image.w, image.h, boxW, boxH, targetW, targetH);
+    if (targetW == image.w && targetH == image.h) {
+        return;
+    }
+    DecodedImage scaled;
+    scaled.allocate(SDL_PIXELFORMAT_IYUV, targetW, targetH);
+    Uint8* y = scaled.writablePixels();
+    Uint8* u = y + static_cast<size_t>(targetW) * targetH;
+    Uint8* v = u + static_cast<size_t>(scaled.chromaWidth()) * scaled.chromaHeight();
+    scalePlane(image.yPlane(), image.w, image.h, image.pitch, y, targetW, targetH, targetW);
+    scalePlane(image.uPlane(), image.chromaWidth(), image.chromaHeight(), image.chromaWidth(), u, scaled.chromaWidth(), scaled.chromaHeight(), scaled.chromaWidth());
+    scalePlane(image.vPlane(), image.chromaWidth(), image.chromaHeight(), image.chromaWidth(), v, scaled.chromaWidth(), scaled.chromaHeight(), scaled.chromaWidth());
+    image = scaled;
+}
+
+// Decodes a JPEG held in memory straight to IYUV planes. Without libjpeg the image goes through
+// SDL_image and SDL_ConvertPixels, which still gives the smaller upload and texture footprint.
+inline bool decodeJpegToIYUV(const Uint8* data, size_t size, const std::string& path, int boxW, int boxH, DecodedImage& out) {
+#ifdef PAMPLEMOUSSE_HAVE_LIBJPEG
+    detail::JpegErrorManager errors;
+    errors.message[0] = '\0';
+    if (!detail::readJpegYCbCr(data, size, boxW, boxH, out, errors)) {
+        logError() << "Failed to decode JPEG " << path << ": " << errors.message;
+        return false;
+    }
+#else
+    SDL_Surface* image = IMG_Load_RW(SDL_RWFromConstMem(data, static_cast<int>(size)), 1);
+    if (!image) {
+        logError() << "Failed to load image " << path << ": " << IMG_GetError();
+        return false;
+    }
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(image);
+    if (!argb) {
+        logError() << "Failed to convert image " << path << ": " << SDL_GetError();
+        return false;
+    }
+    out.allocate(SDL_PIXELFORMAT_IYUV, argb->w, argb->h);
+    int result = SDL_ConvertPixels(argb->w, argb->h, SDL_PIXELFORMAT_ARGB8888, argb->pixels, argb->pitch,
+                                   SDL_PIXELFORMAT_IYUV, out.writablePixels(), out.pitch);
+    SDL_FreeSurface(argb);
+    if (result < 0) {
+        logError() << "Failed to convert image " << path << " to YUV: " << SDL_GetError();
+        return false;
+    }
+#endif
+    scaleYUVToDisplay(out, boxW, boxH);
+    return true;
+}
+
+// Decodes any SDL_image format held in memory to ARGB8888, scaled to the display size for the box.
+inline bool decodeToARGB(const Uint8* data, size_t size, int boxW, int boxH, DecodedImage& out) {
+    SDL_Surface* image = IMG_Load_RW(SDL_RWFromConstMem(data, static_cast<int>(size)), 1);
+    if (!image) {
+        logError() << "Failed to load image: " << IMG_GetError();
+        return false;
+    }
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(image);
+    if (!argb) {
+        logError() << "Failed to convert image: " << SDL_GetError();
+        return false;
+    }
+
+    int targetW, targetH;
+    displaySize(argb->w, argb->h, boxW, boxH, targetW, targetH);
+    if (targetW != argb->w || targetH != argb->h) {
+        SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, targetW, targetH, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (scaled && SDL_SoftStretchLinear(argb, nullptr, scaled, nullptr) == 0) {
+            SDL_FreeSurface(argb);
+            argb = scaled;
+        } else if (scaled) {
+            SDL_FreeSurface(scaled);
+        }
+    }
+
+    out.format = SDL_PIXELFORMAT_ARGB8888;
+    out.w = argb->w;
+    out.h = argb->h;
+    out.pitch = argb->pitch;
+    out.pixels = static_cast<const Uint8*>(argb->pixels);
+    out.storage = std::shared_ptr<void>(argb, [](void* surface) { SDL_FreeSurface(static_cast<SDL_Surface*>(surface)); });
+    return true;
+}
+
+// Decodes an encoded image for display in a boxW x boxH window. With wantYUV, JPEGs come out
+// as IYUV planes; everything else (and JPEGs libjpeg rejects) comes out as ARGB8888.
+inline bool decodeImage(const Uint8* data, size_t size, const std::string& path, bool wantYUV, int boxW, int boxH, DecodedImage& out) {
+    if (wantYUV && isJpegPath(path) && decodeJpegToIYUV(data, size, path, boxW, boxH, out)) {
+        return true;
+    }
+    return decodeToARGB(data, size, boxW, boxH, out);
+}
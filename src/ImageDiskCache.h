@@ -0,0 +1,240 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "CacheFiles.h"
+#include "ImageDecoder.h"
+#include "Log.h"
+
+// On-disk cache of decoded, display-sized pixels under $XDG_CACHE_HOME/pamplemousse/images.
+// Entries are keyed by the source file's identity (path, size, modification time, inode), the
+// display box and the pixel format, and hold raw pixels behind a 64-byte header, so a hit is a
+// stat and an mmap: the source is neither read nor decoded.
+// Writes go to a temp file that is renamed into place; the directory is capped by size,
+// evicting the least recently used entries first.
+class ImageDiskCache {
+public:
+    struct Stats {
+        std::atomic<Uint64> hits{0};
+        std::atomic<Uint64> misses{0};
+        std::atomic<Uint64> writes{0};
+        std::atomic<Uint64> evictions{0};
+    };
+
+    bool init(Uint64 maxBytes) {
+        capBytes = maxBytes;
+        directory = cacheDirectory();
+        enabled = capBytes > 0 && !directory.empty() && makeDirectories(directory);
+        if (capBytes > 0 && !enabled) {
+            logWarning() << "Image disk cache disabled: cannot create " << directory;
+        }
+        return enabled;
+    }
+
+    bool isEnabled() const { return enabled; }
+    const std::string& getDirectory() const { return directory; }
+    const Stats& getStats() const { return stats; }
+
+    static std::string cacheDirectory() {
+        std::string root = cacheRoot();
+        return root.empty() ? root : root + "/images";
+    }
+
+    // Hash of what identifies the source version, combined with everything that shapes the
+    // decoded output. Editing or replacing the image changes its size, mtime or inode.
+    static std::string keyFor(const std::string& sourcePath, const struct stat& source, int boxW, int boxH, Uint32 format) {
+        Uint64 identity[4] = {static_cast<Uint64>(source.st_size), modifiedNs(source), static_cast<Uint64>(source.st_ino),
+                              static_cast<Uint64>(source.st_dev)};
+        Uint64 hash = fnv1a64(identity, sizeof(identity), fnv1a64(sourcePath.data(), sourcePath.size()));
+        char key[64];
+        snprintf(key, sizeof(key), "%016llx-%dx%d-%08x", static_cast<unsigned long long>(hash), boxW, boxH, static_cast<unsigned>(format));
+        return key;
+    }
+
+    bool load(const std::string& key, DecodedImage& out) {
+        std::string path = entryPath(key);
+        size_t size = 0;
+        std::shared_ptr<void> mapping = mapFile(path, size);
+        if (!mapping || size < sizeof(EntryHeader)) {
+            ++stats.misses;
+            return false;
+        }
+
+        const EntryHeader* header = static_cast<const EntryHeader*>(mapping.get());
+        DecodedImage image;
+        image.format = header->format;
+        image.w = header->w;
+        image.h = header->h;
+        image.pitch = header->pitch;
+        bool valid = std::memcmp(header->magic, Magic, sizeof(header->magic)) == 0 && header->version == Version &&
+                     image.w > 0 && image.h > 0 && header->dataBytes == image.byteSize() &&
+                     size == sizeof(EntryHeader) + header->dataBytes;
+        if (!valid) {
+            unlink(path.c_str());
+            ++stats.misses;
+            return false;
+        }
+
+        image.pixels = static_cast<const Uint8*>(mapping.get()) + sizeof(EntryHeader);
+        image.storage = mapping;
+        out = image;
+        utimes(path.c_str(), nullptr); // mtime doubles as the LRU timestamp
+        ++stats.hits;
+        return true;
+    }
+
+    bool store(const std::string& key, const DecodedImage& image) {
+        EntryHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, Magic, sizeof(header.magic));
+        header.version = Version;
+        header.format = image.format;
+        header.w = image.w;
+        header.h = image.h;
+        header.pitch = image.pitch;
+        header.dataBytes = image.byteSize();
+
+        if (!writeFileAtomically(entryPath(key), &header, sizeof(header), image.pixels, header.dataBytes)) {
+            return false;
+        }
+        ++stats.writes;
+        enforceCap();
+        return true;
+    }
+
+    // Deletes the least recently used entries until the directory fits in the cap.
+    void enforceCap() {
+        std::lock_guard<std::mutex> lock(evictionMutex);
+        std::vector<Entry> entries;
+        Uint64 total = 0;
+        time_t now = time(nullptr);
+        listEntries([&](const std::string& path, const struct stat& info, bool temporary) {
+            if (temporary) {
+                // Leftovers from a process that died mid-write.
+                if (now - info.st_mtime > 60) {
+                    unlink(path.c_str());
+                }
+                return;
+            }
+            entries.push_back({path, static_cast<Uint64>(info.st_size), info.st_mtime});
+            total += static_cast<Uint64>(info.st_size);
+        });
+        if (total <= capBytes) {
+            return;
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        for (const Entry& entry : entries) {
+            if (total <= capBytes) {
+                break;
+            }
+            if (unlink(entry.path.c_str()) == 0) {
+                total -= entry.bytes;
+                ++stats.evictions;
+            }
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(evictionMutex);
+        listEntries([](const std::string& path, const struct stat&, bool) { unlink(path.c_str()); });
+    }
+
+private:
+    struct EntryHeader {
+        char magic[4];
+        Uint32 version;
+        Uint32 format;
+        Sint32 w;
+        Sint32 h;
+        Sint32 pitch;
+        Uint64 dataBytes;
+        Uint8 reserved[32]; // pads the header to 64 bytes so pixel rows start cache-line aligned
+    };
+    static_assert(sizeof(EntryHeader) == 64, "cache entry header must stay 64 bytes");
+
+    struct Entry {
+        std::string path;
+        Uint64 bytes;
+        time_t lastUse;
+    };
+
+    static constexpr const char* Magic = "PMPX";
+    static const Uint32 Version = 1;
+
+    std::string directory;
+    Uint64 capBytes = 0;
+    bool enabled = false;
+    std::mutex evictionMutex;
+    Stats stats;
+
+    std::string entryPath(const std::string& key) const { return directory + "/" + key + ".px"; }
+
+    static Uint64 modifiedNs(const struct stat& info) {
+#ifdef __APPLE__
+        const struct timespec& modified = info.st_mtimespec;
+#else
+        const struct timespec& modified = info.st_mtim;
+#endif
+        return static_cast<Uint64>(modified.tv_sec) * 1000000000ULL + static_cast<Uint64>(modified.tv_nsec);
+    }
+
+    template <typename Visitor>
+    void listEntries(Visitor visit) const {
+        DIR* dir = opendir(directory.c_str());
+        if (!dir) {
+            return;
+        }
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            bool temporary = name.find(".px.tmp.") != std::string::npos;
+            bool isEntry = name.size() > 3 && name.compare(name.size() - 3, 3, ".px") == 0;
+            if (!temporary && !isEntry) {
+                continue;
+            }
+            std::string path = directory + "/" + name;
+            struct stat info;
+            if (stat(path.c_str(), &info) == 0) {
+                visit(path, info, temporary);
+            }
+        }
+        closedir(dir);
+    }
+};
+
+// Reads an image and returns its display-sized pixels, from the disk cache when possible.
+inline bool loadDisplayImage(ImageDiskCache& cache, const std::string& imagePath, bool wantYUV, int boxW, int boxH, DecodedImage& out) {
+    std::string key;
+    if (cache.isEnabled()) {
+        struct stat info;
+        if (stat(imagePath.c_str(), &info) == 0) {
+            key = ImageDiskCache::keyFor(imagePath, info, boxW, boxH, wantYUV ? SDL_PIXELFORMAT_IYUV : SDL_PIXELFORMAT_ARGB8888);
+            if (cache.load(key, out)) {
+                return true;
+            }
+        }
+    }
+    std::vector<Uint8> source;
+    if (!readFileBytes(imagePath, source)) {
+        logError() << "Failed to load image: " << imagePath;
+        return false;
+    }
+    if (!decodeImage(source.data(), source.size(), imagePath, wantYUV, boxW, boxH, out)) {
+        return false;
+    }
+    if (!key.empty()) {
+        cache.store(key, out);
+    }
+    return true;
+}
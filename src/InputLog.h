@@ -0,0 +1,160 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CacheFiles.h"
+#include "Log.h"
+
+// One input event the game reacts to, stamped with the frame it was polled in.
+struct InputRecord {
+    Uint32 frame;
+    Uint32 type; // SDL_QUIT or SDL_KEYDOWN
+    SDL_Keycode sym;
+    Uint16 mod;
+    Uint8 repeat;
+};
+
+// Log layout: "PMIR", version, record count, then InputLogRecordBytes per record, little-endian.
+static const char InputLogMagic[4] = {'P', 'M', 'I', 'R'};
+static const Uint32 InputLogVersion = 1;
+static const size_t InputLogHeaderBytes = 12;
+static const size_t InputLogRecordBytes = 12; // frame 4, type 1, key 4, mod 2, repeat 1
+
+// Captures the quit and key-down events consumed by the menu and scene loops. Kept in memory
+// and written in one go when recording stops.
+class InputRecorder {
+public:
+    void start(const std::string& path) {
+        logPath = path;
+        records.clear();
+        recording = true;
+    }
+
+    bool isRecording() const { return recording; }
+
+    void record(Uint32 frame, const SDL_Event& event) {
+        if (!recording || (event.type != SDL_QUIT && event.type != SDL_KEYDOWN)) {
+            return;
+        }
+        InputRecord record = {frame, event.type, 0, 0, 0};
+        if (event.type == SDL_KEYDOWN) {
+            record.sym = event.key.keysym.sym;
+            record.mod = event.key.keysym.mod;
+            record.repeat = event.key.repeat;
+        }
+        records.push_back(record);
+    }
+
+    bool stop() {
+        if (!recording) {
+            return true;
+        }
+        recording = false;
+        Uint8 header[InputLogHeaderBytes];
+        std::memcpy(header, InputLogMagic, 4);
+        putU32(header + 4, InputLogVersion);
+        putU32(header + 8, static_cast<Uint32>(records.size()));
+        std::vector<Uint8> data(records.size() * InputLogRecordBytes);
+        for (size_t i = 0; i < records.size(); ++i) {
+            Uint8* out = data.data() + i * InputLogRecordBytes;
+            putU32(out, records[i].frame);
+            out[4] = records[i].type == SDL_QUIT ? 0 : 1;
+            putU32(out + 5, static_cast<Uint32>(records[i].sym));
+            out[9] = records[i].mod & 0xFF;
+            out[10] = records[i].mod >> 8;
+            out[11] = records[i].repeat;
+        }
+        if (!writeFileAtomically(logPath, header, sizeof(header), data.data(), data.size())) {
+            logError() << "Cannot write input log " << logPath;
+            return false;
+        }
+        std::cout << "Input log written to " << logPath << " (" << records.size() << " events)" << std::endl;
+        return true;
+    }
+
+private:
+    std::string logPath;
+    std::vector<InputRecord> records;
+    bool recording = false;
+
+    static void putU32(Uint8* out, Uint32 value) {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+        out[2] = (value >> 16) & 0xFF;
+        out[3] = value >> 24;
+    }
+};
+
+// Feeds a recorded log back through SDL_PushEvent at the frames it was captured in, so the
+// loops see the same events in the same frames. In fast mode the game skips its frame delays
+// until the log runs out. Live input still works alongside the replay.
+class InputReplayer {
+public:
+    // With quitWhenDone a quit is queued after the last event, so unattended runs always end.
+    bool load(const std::string& path, bool fast, bool quitWhenDone = false) {
+        std::vector<Uint8> bytes;
+        if (!readFileBytes(path, bytes) || bytes.size() < InputLogHeaderBytes || std::memcmp(bytes.data(), InputLogMagic, 4) != 0 ||
+            getU32(bytes.data() + 4) != InputLogVersion) {
+            logError() << "Cannot read input log " << path;
+            return false;
+        }
+        Uint32 count = getU32(bytes.data() + 8);
+        if (bytes.size() != InputLogHeaderBytes + static_cast<size_t>(count) * InputLogRecordBytes) {
+            logError() << "Input log " << path << " is truncated";
+            return false;
+        }
+        records.clear();
+        for (Uint32 i = 0; i < count; ++i) {
+            const Uint8* in = bytes.data() + InputLogHeaderBytes + static_cast<size_t>(i) * InputLogRecordBytes;
+            InputRecord record;
+            record.frame = getU32(in);
+            record.type = in[4] == 0 ? SDL_QUIT : SDL_KEYDOWN;
+            record.sym = static_cast<SDL_Keycode>(getU32(in + 5));
+            record.mod = static_cast<Uint16>(in[9] | (in[10] << 8));
+            record.repeat = in[11];
+            records.push_back(record);
+        }
+        if (quitWhenDone && (records.empty() || records.back().type != SDL_QUIT)) {
+            InputRecord quit = {records.empty() ? 0 : records.back().frame + 1, SDL_QUIT, 0, 0, 0};
+            records.push_back(quit);
+        }
+        next = 0;
+        fastForward = fast;
+        std::cout << "Replaying " << count << " input events from " << path << (fast ? " as fast as possible" : "") << std::endl;
+        return true;
+    }
+
+    bool isActive() const { return next < records.size(); }
+    bool skipsDelays() const { return fastForward && isActive(); }
+
+    // Pushes every event due by this frame. Called before each SDL_PollEvent.
+    void pushDue(Uint32 frame) {
+        while (next < records.size() && records[next].frame <= frame) {
+            const InputRecord& record = records[next++];
+            SDL_Event event;
+            SDL_zero(event);
+            event.type = record.type;
+            if (record.type == SDL_KEYDOWN) {
+                event.key.state = SDL_PRESSED;
+                event.key.repeat = record.repeat;
+                event.key.keysym.sym = record.sym;
+                event.key.keysym.scancode = SDL_GetScancodeFromKey(record.sym);
+                event.key.keysym.mod = record.mod;
+            }
+            if (SDL_PushEvent(&event) < 0) {
+                logError() << "Failed to replay input event: " << SDL_GetError();
+            }
+        }
+    }
+
+private:
+    std::vector<InputRecord> records;
+    size_t next = 0;
+    bool fastForward = false;
+
+    static Uint32 getU32(const Uint8* in) { return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<Uint32>(in[3]) << 24); }
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Trace.h"
+
+// Higher priorities are taken first, by a worker's own queue and by thieves alike.
+enum class JobPriority { High, Normal, Low };
+
+// Shared flag checked before a job starts; a cancelled job that has not started is skipped.
+// Running jobs may poll it too. Copies share the flag.
+class CancellationToken {
+public:
+    CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { cancelled->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled->load(std::memory_order_relaxed); }
+
+    // A fresh flag for the next batch; jobs holding the old one keep seeing it.
+    void reset() { cancelled = std::make_shared<std::atomic<bool>>(false); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    friend class JobSystem;
+};
+
+// Counts the jobs of a batch so a thread can wait for all of them.
+class JobGroup {
+public:
+    JobGroup() = default;
+    JobGroup(const JobGroup&) = delete;
+    JobGroup& operator=(const JobGroup&) = delete;
+
+    bool isDone() const { return pending.load() == 0; }
+
+private:
+    std::atomic<size_t> pending{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    friend class JobSystem;
+};
+
+// Work queued for one particular thread (GPU uploads for the thread that owns the renderer,
+// music insertion for the main thread), run when that thread calls pump().
+class ContinuationQueue {
+public:
+    void post(std::function<void()> continuation) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(continuation));
+    }
+
+    void pump() {
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(queued);
+        }
+        for (std::function<void()>& continuation : ready) {
+            if (continuation) {
+                continuation();
+            }
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::function<void()>> queued;
+};
+
+// Work-stealing scheduler: one worker per core, each with its own deque per priority. A worker
+// takes the newest job from its own deque (its data is still in cache) and, when that is empty,
+// steals the oldest from the others. Jobs submitted from outside are dealt round-robin. With
+// no workers started, jobs run inline on the submitting thread.
+class JobSystem {
+public:
+    struct Stats {
+        std::atomic<Uint64> executed{0};
+        std::atomic<Uint64> stolen{0};
+        std::atomic<Uint64> cancelled{0};
+    };
+
+    JobSystem() = default;
+    explicit JobSystem(unsigned threadCount) { start(threadCount); }
+    ~JobSystem() { stop(); }
+
+    // 0 uses one thread per core.
+    void start(unsigned threadCount) {
+        stop();
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        stopping = false;
+        for (unsigned i = 0; i < threadCount; ++i) {
+            workers.emplace_back(new Worker());
+        }
+        for (unsigned i = 0; i < threadCount; ++i) {
+            workers[i]->thread = std::thread([this, i]() { workerLoop(i); });
+        }
+    }
+
+    // Runs what is still queued, then joins the workers. Cancel first to skip it instead.
+    void stop() {
+        if (workers.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::unique_ptr<Worker>& worker : workers) {
+            worker->thread.join();
+        }
+        workers.clear();
+    }
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+    const Stats& getStats() const { return stats; }
+
+    void submit(std::function<void()> function, JobPriority priority = JobPriority::Normal, JobGroup* group = nullptr,
+                const CancellationToken* token = nullptr) {
+        Job job = {std::move(function), group, token ? token->cancelled : nullptr};
+        if (group) {
+            group->pending.fetch_add(1);
+        }
+        if (workers.empty()) {
+            runJob(job);
+            return;
+        }
+        // A worker keeps what it spawns; the rest is dealt out.
+        size_t index = currentWorker().system == this ? currentWorker().index : nextWorker.fetch_add(1) % workers.size();
+        {
+            std::lock_guard<std::mutex> lock(workers[index]->mutex);
+            workers[index]->queues[static_cast<int>(priority)].push_back(std::move(job));
+        }
+        queued.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // The replacement for std::async: the result arrives through a future.
+    template <typename Function>
+    std::future<decltype(std::declval<Function>()())> async(Function function, JobPriority priority = JobPriority::Normal) {
+        typedef decltype(function()) Result;
+        std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+        std::future<Result> result = task->get_future();
+        submit([task]() { (*task)(); }, priority);
+        return result;
+    }
+
+    // Blocks until every job of the group has run or been skipped. A worker runs other jobs
+    // meanwhile rather than sleep, so waiting inside a job cannot starve the pool.
+    void wait(JobGroup& group) {
+        if (currentWorker().system == this) {
+            while (!group.isDone()) {
+                if (!runNext(currentWorker().index)) {
+                    std::this_thread::yield();
+                }
+            }
+            std::lock_guard<std::mutex> lock(group.mutex); // the last job may still be notifying
+            return;
+        }
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.done.wait(lock, [&group]() { return group.isDone(); });
+    }
+
+private:
+    static const int PriorityCount = 3;
+
+    struct Job {
+        std::function<void()> function;
+        JobGroup* group;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> queues[PriorityCount];
+        std::thread thread;
+    };
+
+    struct WorkerSlot {
+        JobSystem* system = nullptr;
+        size_t index = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> nextWorker{0};
+    std::atomic<size_t> queued{0}; // jobs sitting in a deque
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    Stats stats;
+
+    static WorkerSlot& currentWorker() {
+        static thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    void workerLoop(size_t index) {
+        currentWorker().system = this;
+        currentWorker().index = index;
+        if (tracer().isActive()) {
+            tracer().nameThread("job worker");
+        }
+        while (true) {
+            if (runNext(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]() { return queued.load() > 0 || stopping; });
+            if (stopping && queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    // Own newest first, then the oldest of another worker, one priority level at a time.
+    bool runNext(size_t index) {
+        Job job;
+        for (int priority = 0; priority < PriorityCount; ++priority) {
+            if (takeJob(index, priority, false, job)) {
+                runJob(job);
+                return true;
+            }
+            for (size_t offset = 1; offset < workers.size(); ++offset) {
+                if (takeJob((index + offset) % workers.size(), priority, true, job)) {
+                    stats.stolen.fetch_add(1, std::memory_order_relaxed);
+                    runJob(job);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool takeJob(size_t index, int priority, bool steal, Job& job) {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        std::deque<Job>& queue = worker.queues[priority];
+        if (queue.empty()) {
+            return false;
+        }
+        if (steal) {
+            job = std::move(queue.front());
+            queue.pop_front();
+        } else {
+            job = std::move(queue.back());
+            queue.pop_back();
+        }
+        queued.fetch_sub(1);
+        return true;
+    }
+
+    void runJob(Job& job) {
+        if (job.cancelled && job.cancelled->load(std::memory_order_relaxed)) {
+            stats.cancelled.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            job.function();
+            stats.executed.fetch_add(1, std::memory_order_relaxed);
+        }
+        JobGroup* group = job.group;
+        job = Job();
+        if (group) {
+            // Under the lock, so a waiter that sees the count reach zero cannot free the group
+            // before this is done with it.
+            std::lock_guard<std::mutex> lock(group->mutex);
+            if (group->pending.fetch_sub(1) == 1) {
+                group->done.notify_all();
+            }
+        }
+    }
+};
+
+// The pool shared by everything the game runs in the background. Game::init starts it.
+inline JobSystem& jobs() {
+    static JobSystem system;
+    return system;
+}
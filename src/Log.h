@@ -0,0 +1,247 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "CacheFiles.h"
+#include "RingBuffer.h"
+
+enum class LogLevel { Debug, Info, Warning, Error };
+
+inline const char* logLevelName(LogLevel level) {
+    static const char* names[] = {"debug", "info", "warning", "error"};
+    return names[static_cast<int>(level)];
+}
+
+// One formatted message. Fixed size, so logging never allocates; longer text is cut off.
+struct LogRecord {
+    static constexpr size_t MaxText = 240;
+
+    LogLevel level;
+    Uint64 ticks;
+    Uint16 length;
+    char text[MaxText];
+};
+
+// Writes log messages to stderr from a background thread. Callers format into a fixed buffer and
+// push it onto a lock-free queue, so a log call never blocks on the terminal. The same message
+// is let through at most MaxPerSecond times a second, and the flusher collapses consecutive
+// repeats into one line with a count.
+class Logger {
+public:
+    static constexpr size_t QueueCapacity = 1024;
+    static constexpr int MaxPerSecond = 5;
+    static constexpr int RateSlots = 64;
+
+    Logger() : origin(SDL_GetPerformanceCounter()), flusher([this]() { flushLoop(); }) {}
+
+    ~Logger() { stop(); }
+
+    void setLevel(LogLevel level) { minimum.store(level, std::memory_order_relaxed); }
+    bool accepts(LogLevel level) const { return level >= minimum.load(std::memory_order_relaxed); }
+
+    // Any thread.
+    void submit(const LogRecord& record) {
+        // Counted from before the running check to after the push, so stop() can wait out a
+        // message that saw the flusher still running.
+        submitting.fetch_add(1);
+        if (!running.load()) {
+            submitting.fetch_sub(1);
+            write(record);
+            return;
+        }
+        if (!allow(fnv1a64(record.text, record.length), record.ticks)) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+        } else if (!queue.push(record)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        submitting.fetch_sub(1);
+    }
+
+    // Writes everything queued so far and ends the flusher. Later messages are written directly.
+    void stop() {
+        running.store(false);
+        if (flusher.joinable()) {
+            flusher.join();
+        }
+        // Messages pushed after the flusher's last drain are written here, on the calling thread.
+        while (submitting.load() > 0) {
+            std::this_thread::yield();
+        }
+        flush();
+        reportRepeats();
+    }
+
+private:
+    struct RateSlot {
+        std::atomic<Uint64> key{0};
+        std::atomic<Uint64> windowStart{0};
+        std::atomic<int> count{0};
+    };
+
+    MpscQueue<LogRecord, QueueCapacity> queue;
+    RateSlot rateSlots[RateSlots];
+    std::atomic<LogLevel> minimum{LogLevel::Info};
+    std::atomic<Uint64> suppressed{0};
+    std::atomic<Uint64> dropped{0};
+    std::atomic<bool> running{true};
+    std::atomic<int> submitting{0};
+    Uint64 origin;
+    // Flusher thread only (stop()'s thread once it has joined): the last line written and how
+    // often it has repeated since.
+    LogRecord last = {};
+    Uint64 repeats = 0;
+    Uint64 lastRepeatReport = 0;
+    std::thread flusher;
+
+    // Per-message rate limit over one-second windows. Slots are shared by hash and updated
+    // without a lock, so the limit is approximate when threads race; it only has to stop floods.
+    bool allow(Uint64 key, Uint64 now) {
+        RateSlot& slot = rateSlots[key % RateSlots];
+        Uint64 second = SDL_GetPerformanceFrequency();
+        if (slot.key.load(std::memory_order_relaxed) != key || now - slot.windowStart.load(std::memory_order_relaxed) >= second) {
+            slot.key.store(key, std::memory_order_relaxed);
+            slot.windowStart.store(now, std::memory_order_relaxed);
+            slot.count.store(1, std::memory_order_relaxed);
+            return true;
+        }
+        return slot.count.fetch_add(1, std::memory_order_relaxed) < MaxPerSecond;
+    }
+
+    void flushLoop() {
+        while (running.load(std::memory_order_acquire)) {
+            flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        flush();
+        reportRepeats();
+    }
+
+    void flush() {
+        LogRecord record;
+        bool wrote = false;
+        while (queue.pop(record)) {
+            if (record.level == last.level && record.length == last.length && std::memcmp(record.text, last.text, record.length) == 0) {
+                ++repeats;
+                continue;
+            }
+            reportRepeats();
+            write(record);
+            last = record;
+            wrote = true;
+        }
+        // A message that keeps repeating is summarised once a second rather than when it stops.
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (repeats && now - lastRepeatReport >= SDL_GetPerformanceFrequency()) {
+            reportRepeats();
+            wrote = true;
+        }
+        Uint64 lost = suppressed.exchange(0) + dropped.exchange(0);
+        if (lost) {
+            std::fprintf(stderr, "[%9.3f] warning: %llu log messages suppressed\n", seconds(now), static_cast<unsigned long long>(lost));
+            wrote = true;
+        }
+        if (wrote) {
+            std::fflush(stderr);
+        }
+    }
+
+    void reportRepeats() {
+        lastRepeatReport = SDL_GetPerformanceCounter();
+        if (repeats) {
+            std::fprintf(stderr, "[%9.3f] %s: last message repeated %llu more times\n", seconds(lastRepeatReport), logLevelName(last.level),
+                         static_cast<unsigned long long>(repeats));
+            repeats = 0;
+        }
+    }
+
+    void write(const LogRecord& record) {
+        std::fprintf(stderr, "[%9.3f] %s: %.*s\n", seconds(record.ticks), logLevelName(record.level), static_cast<int>(record.length),
+                     record.text);
+    }
+
+    double seconds(Uint64 ticks) const { return static_cast<double>(ticks - origin) / SDL_GetPerformanceFrequency(); }
+};
+
+inline Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+// Builds one message with stream syntax and hands it to the logger at the end of the statement:
+//     logError() << "Failed to load image: " << IMG_GetError();
+// Formatting stays in a fixed buffer, so nothing is allocated.
+class LogLine {
+public:
+    explicit LogLine(LogLevel level) : enabled(logger().accepts(level)) {
+        record.level = level;
+        record.length = 0;
+    }
+
+    ~LogLine() {
+        if (enabled) {
+            record.ticks = SDL_GetPerformanceCounter();
+            logger().submit(record);
+        }
+    }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLine& operator<<(const char* text) {
+        append(text ? text : "(null)", text ? std::strlen(text) : 6);
+        return *this;
+    }
+
+    LogLine& operator<<(const std::string& text) {
+        append(text.data(), text.size());
+        return *this;
+    }
+
+    LogLine& operator<<(char c) {
+        append(&c, 1);
+        return *this;
+    }
+
+    LogLine& operator<<(double value) {
+        char number[32];
+        int length = std::snprintf(number, sizeof(number), "%g", value);
+        append(number, static_cast<size_t>(length));
+        return *this;
+    }
+
+    template <typename Integer, typename = typename std::enable_if<std::is_integral<Integer>::value>::type>
+    LogLine& operator<<(Integer value) {
+        char number[24];
+        std::to_chars_result result = std::to_chars(number, number + sizeof(number), value);
+        append(number, static_cast<size_t>(result.ptr - number));
+        return *this;
+    }
+
+private:
+    LogRecord record;
+    bool enabled;
+
+    void append(const char* text, size_t length) {
+        if (!enabled) {
+            return;
+        }
+        size_t room = LogRecord::MaxText - record.length;
+        length = std::min(length, room);
+        std::memcpy(record.text + record.length, text, length);
+        record.length = static_cast<Uint16>(record.length + length);
+    }
+};
+
+inline LogLine logDebug() { return LogLine(LogLevel::Debug); }
+inline LogLine logInfo() { return LogLine(LogLevel::Info); }
+inline LogLine logWarning() { return LogLine(LogLevel::Warning); }
+inline LogLine logError() { return LogLine(LogLevel::Error); }
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "Log.h"
+
+// Engine counters for scraping. Written with relaxed stores from the main and render threads and
+// the decode workers, read by the metrics server thread; nothing here takes a lock.
+struct EngineMetrics {
+    std::atomic<Uint64> frames{0};
+    std::atomic<double> frameMsP50{0.0};
+    std::atomic<double> frameMsP99{0.0};
+    std::atomic<double> frameMsMax{0.0};
+    std::atomic<double> inputToPhotonMsP50{0.0};
+    std::atomic<double> inputToPhotonMsP99{0.0};
+    std::atomic<Uint64> texturePoolHits{0};
+    std::atomic<Uint64> texturePoolMisses{0};
+    std::atomic<Uint64> textureBytesResident{0};
+    std::atomic<Uint64> diskCacheHits{0};
+    std::atomic<Uint64> diskCacheMisses{0};
+    std::atomic<Uint64> imagesDecoded{0};
+    std::atomic<Sint64> decodeQueueDepth{0};
+    std::atomic<Uint64> musicUnderruns{0};
+    std::atomic<Uint64> voiceUnderruns{0};
+    std::atomic<Uint64> audioLateCallbacks{0};
+    std::atomic<double> timeToFirstFrameMs{0.0};
+
+    // Prometheus text exposition format, version 0.0.4.
+    std::string render() const {
+        std::string out;
+        double textureHits = static_cast<double>(texturePoolHits.load(std::memory_order_relaxed));
+        double textureMisses = static_cast<double>(texturePoolMisses.load(std::memory_order_relaxed));
+        double diskHits = static_cast<double>(diskCacheHits.load(std::memory_order_relaxed));
+        double diskMisses = static_cast<double>(diskCacheMisses.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_frames_total", "counter", "Frames presented.", frames.load(std::memory_order_relaxed));
+        appendHeader(out, "pamplemousse_frame_time_ms", "gauge", "Frame time over the last 512 frames.");
+        appendSample(out, "pamplemousse_frame_time_ms{quantile=\"0.5\"}", frameMsP50.load(std::memory_order_relaxed));
+        appendSample(out, "pamplemousse_frame_time_ms{quantile=\"0.99\"}", frameMsP99.load(std::memory_order_relaxed));
+        appendSample(out, "pamplemousse_frame_time_ms{quantile=\"1\"}", frameMsMax.load(std::memory_order_relaxed));
+        appendHeader(out, "pamplemousse_input_to_photon_ms", "gauge", "From polling a key to presenting the frame that answers it.");
+        appendSample(out, "pamplemousse_input_to_photon_ms{quantile=\"0.5\"}", inputToPhotonMsP50.load(std::memory_order_relaxed));
+        appendSample(out, "pamplemousse_input_to_photon_ms{quantile=\"0.99\"}", inputToPhotonMsP99.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_texture_pool_hits_total", "counter", "Texture acquisitions served from the pool.", textureHits);
+        appendMetric(out, "pamplemousse_texture_pool_misses_total", "counter", "Texture acquisitions that created a texture.", textureMisses);
+        appendMetric(out, "pamplemousse_texture_pool_hit_ratio", "gauge", "Texture pool hits over acquisitions.", ratio(textureHits, textureMisses));
+        appendMetric(out, "pamplemousse_texture_resident_bytes", "gauge", "Bytes held by pooled textures.",
+                     textureBytesResident.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_disk_cache_hits_total", "counter", "Decoded images read from the disk cache.", diskHits);
+        appendMetric(out, "pamplemousse_disk_cache_misses_total", "counter", "Decoded images missing from the disk cache.", diskMisses);
+        appendMetric(out, "pamplemousse_disk_cache_hit_ratio", "gauge", "Disk cache hits over lookups.", ratio(diskHits, diskMisses));
+        appendMetric(out, "pamplemousse_images_decoded_total", "counter", "Background images decoded.", imagesDecoded.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_decode_queue_depth", "gauge", "Image decodes queued or running on workers.",
+                     decodeQueueDepth.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_music_underruns_total", "counter", "Music stream callbacks that ran dry.", musicUnderruns.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_voice_underruns_total", "counter", "Voice stream callbacks that ran dry.", voiceUnderruns.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_audio_late_callbacks_total", "counter", "Audio callbacks late enough for the device to run dry.",
+                     audioLateCallbacks.load(std::memory_order_relaxed));
+        appendMetric(out, "pamplemousse_time_to_first_frame_ms", "gauge", "Time from the start of init to the first frame.",
+                     timeToFirstFrameMs.load(std::memory_order_relaxed));
+        return out;
+    }
+
+private:
+    static double ratio(double hits, double misses) { return hits + misses > 0 ? hits / (hits + misses) : 0.0; }
+
+    static void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+        out += "# HELP ";
+        out += name;
+        out += " ";
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += " ";
+        out += type;
+        out += "\n";
+    }
+
+    static void appendSample(std::string& out, const char* name, double value) {
+        char line[160];
+        snprintf(line, sizeof(line), "%s %.17g\n", name, value);
+        out += line;
+    }
+
+    static void appendMetric(std::string& out, const char* name, const char* type, const char* help, double value) {
+        appendHeader(out, name, type, help);
+        appendSample(out, name, value);
+    }
+};
+
+// Serves GET /metrics on 127.0.0.1:port from a background thread, one request per connection.
+// Only loopback is bound, so the counters are not exposed beyond the machine.
+class MetricsServer {
+public:
+    ~MetricsServer() { stop(); }
+
+    bool start(int port, const EngineMetrics& engineMetrics) {
+        stop();
+        listenFd = socket(AF_INET, SOCK_STREAM, 0); // SOCK_CLOEXEC and accept4 are Linux-only
+        if (listenFd < 0) {
+            logWarning() << "Metrics endpoint disabled: cannot create socket: " << std::strerror(errno);
+            return false;
+        }
+        setCloseOnExec(listenFd);
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, 8) != 0) {
+            logWarning() << "Metrics endpoint disabled: cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno);
+            close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        metrics = &engineMetrics;
+        running.store(true);
+        server = std::thread([this]() { serveLoop(); });
+        std::cout << "Serving metrics on http://127.0.0.1:" << port << "/metrics" << std::endl;
+        return true;
+    }
+
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    void stop() {
+        running.store(false);
+        if (server.joinable()) {
+            server.join();
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+    }
+
+private:
+    static const int PollMs = 200; // how quickly stop() is noticed
+    int listenFd = -1;
+    std::atomic<bool> running{false};
+    std::thread server;
+    const EngineMetrics* metrics = nullptr;
+
+    void serveLoop() {
+        pollfd listener = {listenFd, POLLIN, 0};
+        while (running.load()) {
+            listener.revents = 0;
+            if (poll(&listener, 1, PollMs) <= 0) {
+                continue;
+            }
+            int client = accept(listenFd, nullptr, nullptr);
+            if (client >= 0) {
+                setCloseOnExec(client);
+#ifdef SO_NOSIGPIPE
+                int noSigPipe = 1; // macOS has no MSG_NOSIGNAL; a client hanging up must not kill the game
+                setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+                respond(client);
+                close(client);
+            }
+        }
+    }
+
+    void respond(int client) {
+        // A scrape request fits in one read; wait briefly for it, never for a slow client.
+        pollfd readable = {client, POLLIN, 0};
+        char request[1024];
+        ssize_t received = poll(&readable, 1, PollMs) > 0 ? recv(client, request, sizeof(request) - 1, 0) : -1;
+        if (received <= 0) {
+            return;
+        }
+        request[received] = '\0';
+        std::string body;
+        const char* status = "200 OK";
+        if (std::strncmp(request, "GET /metrics", 12) == 0) {
+            body = metrics->render();
+        } else {
+            status = "404 Not Found";
+            body = "Try /metrics\n";
+        }
+        char header[160];
+        int headerBytes = snprintf(header, sizeof(header),
+                                   "HTTP/1.1 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                                   status, body.size());
+        sendAll(client, header, static_cast<size_t>(headerBytes));
+        sendAll(client, body.data(), body.size());
+    }
+
+    static void setCloseOnExec(int fd) {
+        int flags = fcntl(fd, F_GETFD);
+        if (flags >= 0) {
+            fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+        }
+    }
+
+    static void sendAll(int fd, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0; // SO_NOSIGPIPE is set on the socket instead
+#endif
+        while (size > 0) {
+            ssize_t sent = send(fd, data, size, flags);
+            if (sent <= 0) {
+                return;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <thread>
+
+#include "RingBuffer.h"
+#include "Trace.h"
+#include "core/Story.h"
+
+// Everything the render thread needs to draw one frame, by ID into data that does not change
+// while the game runs (the story, the menu labels). Plain values, so frames cross the queue by copy.
+struct FrameDescription {
+    enum Kind : Uint8 { Menu, Scene, Black, Quit };
+    enum Request : Uint8 { ReportStats = 1, ToggleOverlay = 2 };
+
+    Kind kind;
+    Uint8 requests;     // Request bits, handled before drawing
+    Sint16 chapterID;   // Scene frames: which scene, for residency ranking
+    Sint16 sceneID;
+    Sint32 background;  // index into the background image table, -1 for none
+    Sint32 text;        // index into the text box table, -1 for none
+    Color color;        // clear colour
+    Uint64 inputTicks;  // when the input this frame answers was polled, 0 if none
+    Uint64 serial;      // frames submitted before this one
+};
+
+// Runs drawing on its own thread. The main thread keeps the window, the event loop and the game
+// logic, and hands over one FrameDescription per frame through a lock-free SPSC queue; a semaphore
+// only wakes the render thread up. The renderer is created, used and destroyed on the render
+// thread, so no SDL_Render call ever crosses threads.
+//
+// Experimental and off by default (--render-thread): SDL only supports rendering on the main
+// thread, and some drivers (Metal and OpenGL on macOS, some Windows ones) fail or crash when it
+// happens elsewhere, so it is never used on macOS. The supported split keeps the window, events and
+// drawing on the main thread and moves logic, audio and sequencing to a worker; that inversion is
+// not done yet.
+class RenderThread {
+public:
+    static const size_t QueueCapacity = 64;
+
+    typedef std::function<bool()> SetupFn;                    // creates the renderer
+    typedef std::function<void(const FrameDescription&)> DrawFn;
+    typedef std::function<void()> TeardownFn;                 // destroys it
+
+    ~RenderThread() { stop(); }
+
+    void start(SetupFn setup, DrawFn draw, TeardownFn teardown) {
+        wake = SDL_CreateSemaphore(0);
+        std::promise<bool> readyPromise;
+        ready = readyPromise.get_future();
+        running.store(true);
+        thread = std::thread([this, setup, draw, teardown](std::promise<bool> promise) {
+            if (tracer().isActive()) {
+                tracer().nameThread("render");
+            }
+            bool ok = setup();
+            promise.set_value(ok);
+            if (ok) {
+                loop(draw);
+            }
+            teardown();
+        }, std::move(readyPromise));
+    }
+
+    // Blocks until the renderer exists. False if it could not be created.
+    bool waitUntilReady() { return ready.valid() ? ready.get() : isRunning(); }
+
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Main thread. False when the render thread is behind by QueueCapacity frames.
+    bool submit(const FrameDescription& frame) {
+        if (!frames.push(frame)) {
+            return false;
+        }
+        SDL_SemPost(wake);
+        return true;
+    }
+
+    // Draws whatever is queued, tears down on the render thread and joins it.
+    void stop() {
+        if (!thread.joinable()) {
+            return;
+        }
+        FrameDescription quit = {};
+        quit.kind = FrameDescription::Quit;
+        while (!frames.push(quit)) {
+            SDL_Delay(1);
+        }
+        SDL_SemPost(wake);
+        thread.join();
+        running.store(false);
+        SDL_DestroySemaphore(wake);
+        wake = nullptr;
+    }
+
+private:
+    SpscQueue<FrameDescription, QueueCapacity> frames;
+    SDL_sem* wake = nullptr;
+    std::future<bool> ready;
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    // When several frames are waiting, only the newest is drawn; the requests and the oldest
+    // input timestamp of the skipped ones carry over to it.
+    void loop(const DrawFn& draw) {
+        while (true) {
+            SDL_SemWait(wake);
+            FrameDescription frame;
+            if (!frames.pop(frame)) {
+                continue; // woken for a frame already drawn as part of a batch
+            }
+            if (frame.kind == FrameDescription::Quit) {
+                return;
+            }
+            FrameDescription next;
+            bool quit = false;
+            while (frames.pop(next)) {
+                if (next.kind == FrameDescription::Quit) {
+                    quit = true; // still draw the newest frame first
+                    break;
+                }
+                next.requests |= frame.requests;
+                if (frame.inputTicks && (!next.inputTicks || frame.inputTicks < next.inputTicks)) {
+                    next.inputTicks = frame.inputTicks;
+                }
+                frame = next;
+            }
+            draw(frame);
+            if (quit) {
+                return;
+            }
+        }
+    }
+};
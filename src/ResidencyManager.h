@@ -0,0 +1,266 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class AssetClass { Texture, Text, Font, Music, Sound, Count };
+enum class EvictionPolicy { LRU, GraphDistance };
+
+// Tracks the CPU and GPU bytes of every loaded asset, enforces per-class budgets and
+// reports residency. Assets registered without an evict callback are pinned.
+//
+// Shared by the main thread (music, sound effects) and the thread that draws (textures, text):
+// the bookkeeping is under a lock, and each class has its own frame counter and budget, advanced
+// and enforced by the thread that owns the class. Evict callbacks run outside the lock, on the
+// thread that calls enforceBudget().
+class ResidencyManager {
+public:
+    typedef Uint64 AssetID;
+
+    struct Budget {
+        Uint64 cpuBytes = 0; // 0 means unlimited
+        Uint64 gpuBytes = 0;
+        EvictionPolicy policy = EvictionPolicy::LRU;
+    };
+
+    struct ClassStats {
+        Uint64 count = 0;
+        Uint64 cpuBytes = 0;
+        Uint64 gpuBytes = 0;
+        Uint64 peakCpuBytes = 0;
+        Uint64 peakGpuBytes = 0;
+        Uint64 evictions = 0;
+    };
+
+    static const int Unreachable = INT_MAX;
+
+    AssetID registerAsset(AssetClass assetClass, const std::string& key, Uint64 cpuBytes, Uint64 gpuBytes,
+                          std::function<void()> evict = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        AssetID id = nextID++;
+        Asset& asset = assets[id];
+        asset.assetClass = assetClass;
+        asset.key = key;
+        asset.cpuBytes = cpuBytes;
+        asset.gpuBytes = gpuBytes;
+        asset.lastUse = frames[index(assetClass)];
+        asset.distance = distanceFor(key);
+        asset.evict = std::move(evict);
+
+        ClassStats& stats = classStats[index(assetClass)];
+        ++stats.count;
+        stats.cpuBytes += cpuBytes;
+        stats.gpuBytes += gpuBytes;
+        stats.peakCpuBytes = std::max(stats.peakCpuBytes, stats.cpuBytes);
+        stats.peakGpuBytes = std::max(stats.peakGpuBytes, stats.gpuBytes);
+        return id;
+    }
+
+    void unregisterAsset(AssetID id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        unregisterLocked(id);
+    }
+
+    void touch(AssetID id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = assets.find(id);
+        if (it != assets.end()) {
+            it->second.lastUse = frames[index(it->second.assetClass)];
+        }
+    }
+
+    // Assets of the class touched during its current frame are never evicted.
+    void beginFrame(AssetClass assetClass) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++frames[index(assetClass)];
+    }
+
+    void setBudget(AssetClass assetClass, const Budget& budget) {
+        std::lock_guard<std::mutex> lock(mutex);
+        budgets[index(assetClass)] = budget;
+    }
+
+    // Distances (in choices) from the current scene, keyed by asset key. Keys that are
+    // missing count as unreachable, so the graph-distance policy evicts them first.
+    void setGraphDistances(const std::unordered_map<std::string, int>& distances) {
+        std::lock_guard<std::mutex> lock(mutex);
+        graphDistances = distances;
+        for (auto& entry : assets) {
+            entry.second.distance = distanceFor(entry.second.key);
+        }
+    }
+
+    // Evicts assets of the class until it is back under budget. Returns the number evicted.
+    // Call it from the thread that owns the class: that is where the callbacks run.
+    int enforceBudget(AssetClass assetClass) {
+        std::vector<std::pair<AssetID, std::function<void()>>> victims;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pickVictims(assetClass, victims);
+        }
+        // The callbacks release the asset and may unregister it themselves.
+        for (auto& victim : victims) {
+            victim.second();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& victim : victims) {
+            unregisterLocked(victim.first);
+            ++classStats[index(assetClass)].evictions;
+        }
+        return static_cast<int>(victims.size());
+    }
+
+    ClassStats getStats(AssetClass assetClass) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return classStats[index(assetClass)];
+    }
+
+    Uint64 totalBytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totalBytesLocked();
+    }
+
+    // Every class in one table, whichever thread owns it.
+    std::string report() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ostringstream out;
+        out << "Asset residency (" << assets.size() << " assets, " << totalBytesLocked() / 1024 << " KiB total)\n";
+        out << std::left << std::setw(9) << "class" << std::right << std::setw(7) << "count"
+            << std::setw(11) << "cpu KiB" << std::setw(11) << "gpu KiB" << std::setw(11) << "peak KiB"
+            << std::setw(12) << "budget KiB" << std::setw(15) << "policy" << std::setw(11) << "evictions" << "\n";
+        for (int c = 0; c < static_cast<int>(AssetClass::Count); ++c) {
+            const ClassStats& stats = classStats[c];
+            const Budget& budget = budgets[c];
+            Uint64 budgetBytes = budget.cpuBytes + budget.gpuBytes;
+            out << std::left << std::setw(9) << className(static_cast<AssetClass>(c)) << std::right
+                << std::setw(7) << stats.count
+                << std::setw(11) << stats.cpuBytes / 1024
+                << std::setw(11) << stats.gpuBytes / 1024
+                << std::setw(11) << (stats.peakCpuBytes + stats.peakGpuBytes) / 1024
+                << std::setw(12) << (budgetBytes ? std::to_string(budgetBytes / 1024) : std::string("-"))
+                << std::setw(15) << (budget.policy == EvictionPolicy::LRU ? "lru" : "graph-distance")
+                << std::setw(11) << stats.evictions << "\n";
+        }
+        return out.str();
+    }
+
+    static const char* className(AssetClass assetClass) {
+        switch (assetClass) {
+            case AssetClass::Texture: return "texture";
+            case AssetClass::Text: return "text";
+            case AssetClass::Font: return "font";
+            case AssetClass::Music: return "music";
+            case AssetClass::Sound: return "sound";
+            default: return "?";
+        }
+    }
+
+    // Size of a file on disk, used as the resident cost of streamed assets (fonts, music).
+    static Uint64 fileBytes(const std::string& path) {
+        SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+        if (!file) {
+            return 0;
+        }
+        Sint64 size = SDL_RWsize(file);
+        SDL_RWclose(file);
+        return size > 0 ? static_cast<Uint64>(size) : 0;
+    }
+
+private:
+    struct Asset {
+        AssetClass assetClass;
+        std::string key;
+        Uint64 cpuBytes;
+        Uint64 gpuBytes;
+        Uint64 lastUse;
+        int distance;
+        std::function<void()> evict;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<AssetID, Asset> assets;
+    std::unordered_map<std::string, int> graphDistances;
+    Budget budgets[static_cast<int>(AssetClass::Count)];
+    ClassStats classStats[static_cast<int>(AssetClass::Count)];
+    AssetID nextID = 1;
+    Uint64 frames[static_cast<int>(AssetClass::Count)] = {};
+
+    static int index(AssetClass assetClass) { return static_cast<int>(assetClass); }
+
+    int distanceFor(const std::string& key) const {
+        auto it = graphDistances.find(key);
+        return it == graphDistances.end() ? Unreachable : it->second;
+    }
+
+    void unregisterLocked(AssetID id) {
+        auto it = assets.find(id);
+        if (it == assets.end()) {
+            return;
+        }
+        ClassStats& stats = classStats[index(it->second.assetClass)];
+        --stats.count;
+        stats.cpuBytes -= it->second.cpuBytes;
+        stats.gpuBytes -= it->second.gpuBytes;
+        assets.erase(it);
+    }
+
+    Uint64 totalBytesLocked() const {
+        Uint64 total = 0;
+        for (const ClassStats& stats : classStats) {
+            total += stats.cpuBytes + stats.gpuBytes;
+        }
+        return total;
+    }
+
+    bool overBudget(AssetClass assetClass) const {
+        const Budget& budget = budgets[index(assetClass)];
+        const ClassStats& stats = classStats[index(assetClass)];
+        return (budget.cpuBytes && stats.cpuBytes > budget.cpuBytes) || (budget.gpuBytes && stats.gpuBytes > budget.gpuBytes);
+    }
+
+    // The assets to evict to bring the class back under budget, with their callbacks.
+    void pickVictims(AssetClass assetClass, std::vector<std::pair<AssetID, std::function<void()>>>& victims) const {
+        if (!overBudget(assetClass)) {
+            return;
+        }
+
+        std::vector<std::pair<AssetID, const Asset*>> candidates;
+        for (const auto& entry : assets) {
+            const Asset& asset = entry.second;
+            if (asset.assetClass == assetClass && asset.evict && asset.lastUse != frames[index(assetClass)]) {
+                candidates.push_back({entry.first, &asset});
+            }
+        }
+
+        // Most evictable first: least recently used, or furthest from the current scene
+        // with least recently used breaking ties.
+        bool byDistance = budgets[index(assetClass)].policy == EvictionPolicy::GraphDistance;
+        std::sort(candidates.begin(), candidates.end(), [byDistance](const auto& a, const auto& b) {
+            if (byDistance && a.second->distance != b.second->distance) {
+                return a.second->distance > b.second->distance;
+            }
+            return a.second->lastUse < b.second->lastUse;
+        });
+
+        Uint64 cpuBytes = classStats[index(assetClass)].cpuBytes;
+        Uint64 gpuBytes = classStats[index(assetClass)].gpuBytes;
+        const Budget& budget = budgets[index(assetClass)];
+        for (const auto& candidate : candidates) {
+            if ((!budget.cpuBytes || cpuBytes <= budget.cpuBytes) && (!budget.gpuBytes || gpuBytes <= budget.gpuBytes)) {
+                break;
+            }
+            cpuBytes -= candidate.second->cpuBytes;
+            gpuBytes -= candidate.second->gpuBytes;
+            victims.push_back({candidate.first, candidate.second->evict});
+        }
+    }
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Lock-free single-producer single-consumer byte ring. Capacity is rounded up to a power of two.
+// The producer only moves head and the consumer only moves tail, so neither side ever blocks.
+class SpscByteRing {
+public:
+    explicit SpscByteRing(size_t minCapacity = 0) { reset(minCapacity); }
+
+    // Not thread-safe: call before either side starts using the ring.
+    void reset(size_t minCapacity) {
+        size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        buffer.assign(minCapacity ? capacity : 0, 0);
+        mask = buffer.empty() ? 0 : capacity - 1;
+        head.store(0);
+        tail.store(0);
+    }
+
+    size_t capacity() const { return buffer.size(); }
+    size_t readable() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed); }
+    size_t writable() const { return buffer.size() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire)); }
+
+    // Producer side. Writes as much as fits and returns the number of bytes written.
+    size_t write(const void* data, size_t bytes) {
+        size_t writePos = head.load(std::memory_order_relaxed);
+        size_t space = buffer.size() - (writePos - tail.load(std::memory_order_acquire));
+        bytes = std::min(bytes, space);
+        copyIn(writePos, static_cast<const unsigned char*>(data), bytes);
+        head.store(writePos + bytes, std::memory_order_release);
+        return bytes;
+    }
+
+    // Consumer side. Reads up to bytes and returns the number of bytes read.
+    size_t read(void* out, size_t bytes) {
+        size_t readPos = tail.load(std::memory_order_relaxed);
+        size_t available = head.load(std::memory_order_acquire) - readPos;
+        bytes = std::min(bytes, available);
+        copyOut(readPos, static_cast<unsigned char*>(out), bytes);
+        tail.store(readPos + bytes, std::memory_order_release);
+        return bytes;
+    }
+
+private:
+    std::vector<unsigned char> buffer;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+
+    void copyIn(size_t position, const unsigned char* data, size_t bytes) {
+        size_t offset = position & mask;
+        size_t first = std::min(bytes, buffer.size() - offset);
+        std::memcpy(buffer.data() + offset, data, first);
+        std::memcpy(buffer.data(), data + first, bytes - first);
+    }
+
+    void copyOut(size_t position, unsigned char* out, size_t bytes) const {
+        size_t offset = position & mask;
+        size_t first = std::min(bytes, buffer.size() - offset);
+        std::memcpy(out, buffer.data() + offset, first);
+        std::memcpy(out + first, buffer.data(), bytes - first);
+    }
+};
+
+// Lock-free single-producer single-consumer queue of trivially copyable values, fixed capacity.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    bool push(const T& value) {
+        size_t writePos = head.load(std::memory_order_relaxed);
+        if (writePos - tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[writePos & (Capacity - 1)] = value;
+        head.store(writePos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t readPos = tail.load(std::memory_order_relaxed);
+        if (readPos == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[readPos & (Capacity - 1)];
+        tail.store(readPos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+// Lock-free bounded multi-producer single-consumer queue of fixed-size values. Each slot
+// carries a sequence number, so producers claim slots with one compare-exchange on head and
+// the consumer sees a slot only once its producer has finished writing it.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Any thread. Returns false when the queue is full.
+    bool push(const T& value) {
+        size_t writePos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[writePos & (Capacity - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t lag = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(writePos);
+            if (lag == 0) {
+                if (head.compare_exchange_weak(writePos, writePos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(writePos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                writePos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only.
+    bool pop(T& value) {
+        Slot& slot = slots[tail & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+            return false;
+        }
+        value = slot.value;
+        slot.sequence.store(tail + Capacity, std::memory_order_release);
+        ++tail;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot slots[Capacity];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t tail = 0;
+};
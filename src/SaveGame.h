@@ -0,0 +1,129 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CacheFiles.h"
+#include "JobSystem.h"
+#include "core/SaveSnapshot.h"
+
+// Save slots under $XDG_DATA_HOME/pamplemousse/saves, one small file each. Slot 0 is the
+// autosave, written on every scene change; the others are written when the player asks.
+//
+// save() encodes the snapshot on the calling thread into a reused buffer, which takes a few
+// microseconds, and leaves the disk to a job: one write of the whole file to a temp file, synced,
+// then a rename over the slot. One writer job runs at a time and a newer snapshot of a slot replaces one
+// not yet written, so each slot is written in order and a burst of scene changes costs one write.
+class SaveSlots {
+public:
+    static const int AutosaveSlot = 0;
+    static const int SlotCount = 10;
+
+    struct Stats {
+        std::atomic<Uint64> written{0};
+        std::atomic<Uint64> superseded{0}; // replaced before the writer got to them
+        std::atomic<Uint64> failed{0};
+    };
+
+    SaveSlots() = default;
+    SaveSlots(const SaveSlots&) = delete;
+    SaveSlots& operator=(const SaveSlots&) = delete;
+    ~SaveSlots() { flush(); }
+
+    // Saves are tied to the story they were made with.
+    void setStory(const Story& story) { fingerprint = save::storyFingerprint(story); }
+
+    static bool isValidSlot(int slot) { return slot >= 0 && slot < SlotCount; }
+
+    static std::string slotPath(int slot) {
+        std::string root = dataRoot();
+        return root.empty() ? "" : root + "/saves/slot-" + std::to_string(slot) + ".sav";
+    }
+
+    // Main thread. False if the slot does not exist; a failed write only shows in the stats.
+    bool save(int slot, const SaveState& state) {
+        if (!isValidSlot(slot)) {
+            return false;
+        }
+        Uint64 savedAtMs = static_cast<Uint64>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+        save::encode(state, fingerprint, savedAtMs, spare);
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Pending& pending = slots[slot];
+            if (pending.dirty) {
+                stats.superseded.fetch_add(1, std::memory_order_relaxed);
+            }
+            pending.bytes.swap(spare); // the buffers circulate, so saving does not allocate once warm
+            pending.dirty = true;
+            if (!writerQueued) {
+                writerQueued = true;
+                schedule = true;
+            }
+        }
+        if (schedule) {
+            jobs().submit([this]() { writePending(); }, JobPriority::Low, &writes);
+        }
+        return true;
+    }
+
+    // Maps the slot and decodes it. False if it is missing, damaged or from another story.
+    bool load(int slot, SaveState& state) const {
+        if (!isValidSlot(slot)) {
+            return false;
+        }
+        size_t size = 0;
+        std::shared_ptr<void> mapping = mapFile(slotPath(slot), size);
+        return mapping && save::decode(mapping.get(), size, fingerprint, state);
+    }
+
+    // Blocks until every save so far is on disk, e.g. before quitting.
+    void flush() { jobs().wait(writes); }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Pending {
+        std::vector<Uint8> bytes;
+        bool dirty = false;
+    };
+
+    std::uint32_t fingerprint = 0;
+    std::vector<Uint8> spare;    // main thread: the next snapshot is encoded here
+    std::vector<Uint8> writing;  // writer job: the snapshot going to disk
+    std::mutex mutex;
+    Pending slots[SlotCount];
+    bool writerQueued = false;
+    JobGroup writes;
+    Stats stats;
+
+    // Writer job: writes the dirty slots until there are none left.
+    void writePending() {
+        while (true) {
+            int slot = -1;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (int i = 0; i < SlotCount && slot < 0; ++i) {
+                    if (slots[i].dirty) {
+                        slot = i;
+                        slots[i].dirty = false;
+                        writing.swap(slots[i].bytes);
+                    }
+                }
+                if (slot < 0) {
+                    writerQueued = false;
+                    return;
+                }
+            }
+            std::string root = dataRoot();
+            bool written = !root.empty() && makeDirectories(root + "/saves") &&
+                           writeFileAtomically(slotPath(slot), writing.data(), writing.size(), nullptr, 0, true);
+            (written ? stats.written : stats.failed).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
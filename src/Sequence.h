@@ -0,0 +1,345 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Timed behaviour (transitions, menus, later text reveals and auto-advance) written as coroutines
+// that co_await frames, timers, conditions and key presses instead of blocking the main loop.
+//
+//     Sequence fadeThrough(Sequencer& s) {
+//         blackout = true;
+//         co_await s.delay(300);
+//         blackout = false;
+//     }
+//
+// Everything runs on the main thread: the main loop feeds keys to dispatchKey() and calls
+// advance() once per frame, which resumes whatever is due. Awaiters live in the coroutine frame
+// and the frames come from SequenceFrames, so awaiting never touches the heap.
+
+// Free lists of coroutine frames by size class, carved from chunks that are never returned.
+// Once the first few sequences have run, starting another one does not allocate. Main thread only.
+class SequenceFrames {
+public:
+    static const size_t ChunkBytes = 64 * 1024;
+
+    struct Stats {
+        std::uint64_t frames = 0;
+        std::uint64_t heapFallbacks = 0; // frames bigger than the largest class
+        size_t chunkBytes = 0;
+    };
+
+    SequenceFrames() = default;
+    SequenceFrames(const SequenceFrames&) = delete;
+    SequenceFrames& operator=(const SequenceFrames&) = delete;
+
+    ~SequenceFrames() {
+        for (void* chunk : chunks) {
+            ::operator delete(chunk);
+        }
+    }
+
+    void* allocate(size_t size) {
+        ++stats.frames;
+        int sizeClass = classOf(size);
+        if (sizeClass < 0) {
+            ++stats.heapFallbacks;
+            return ::operator new(size);
+        }
+        FreeBlock* block = freeLists[sizeClass];
+        if (block) {
+            freeLists[sizeClass] = block->next;
+            return block;
+        }
+        return carve(ClassBytes[sizeClass]);
+    }
+
+    void release(void* pointer, size_t size) {
+        int sizeClass = classOf(size);
+        if (sizeClass < 0) {
+            ::operator delete(pointer);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    static constexpr size_t ClassBytes[] = {128, 256, 512, 1024, 2048};
+    static const int ClassCount = 5;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    FreeBlock* freeLists[ClassCount] = {};
+    std::vector<void*> chunks;
+    char* cursor = nullptr;
+    size_t left = 0;
+    Stats stats;
+
+    static int classOf(size_t size) {
+        for (int i = 0; i < ClassCount; ++i) {
+            if (size <= ClassBytes[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void* carve(size_t bytes) {
+        if (left < bytes) {
+            cursor = static_cast<char*>(::operator new(ChunkBytes));
+            chunks.push_back(cursor);
+            left = ChunkBytes;
+            stats.chunkBytes += ChunkBytes;
+        }
+        void* block = cursor;
+        cursor += bytes; // class sizes are multiples of the strictest alignment
+        left -= bytes;
+        return block;
+    }
+};
+
+inline SequenceFrames& sequenceFrames() {
+    static SequenceFrames frames;
+    return frames;
+}
+
+// A coroutine run by a Sequencer, or awaited by another Sequence, which then continues when it ends.
+class Sequence {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+
+        Sequence get_return_object() { return Sequence(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                std::coroutine_handle<> next = handle.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(size_t size) { return sequenceFrames().allocate(size); }
+        static void operator delete(void* pointer, size_t size) { sequenceFrames().release(pointer, size); }
+    };
+
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    Sequence() = default;
+    Sequence(Sequence&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Sequence& operator=(Sequence&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Sequence() { reset(); }
+
+    bool isDone() const { return !handle || handle.done(); }
+
+    // co_await child: runs the child now and continues here once it has finished.
+    bool await_ready() const { return isDone(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) {
+        handle.promise().continuation = caller;
+        return handle;
+    }
+    void await_resume() {}
+
+private:
+    Handle handle;
+
+    explicit Sequence(Handle handle) : handle(handle) {}
+
+    void reset() {
+        if (handle) {
+            handle.destroy();
+            handle = nullptr;
+        }
+    }
+
+    friend class Sequencer;
+};
+
+// Owns the running sequences and resumes them when what they wait for has happened. Time is
+// the sum of the frame steps given to advance(), so input replays see the same timings.
+class Sequencer {
+public:
+    static const size_t ExpectedWaiters = 32; // reserved up front; more still works
+
+    Sequencer() {
+        roots.reserve(ExpectedWaiters);
+        waiting.reserve(ExpectedWaiters);
+        ready.reserve(ExpectedWaiters);
+    }
+
+    ~Sequencer() { clear(); }
+
+    void start(Sequence sequence) {
+        if (sequence.isDone()) {
+            return;
+        }
+        Sequence::Handle handle = std::exchange(sequence.handle, nullptr);
+        roots.push_back(handle);
+        handle.resume();
+        reap();
+    }
+
+    // Resumes what waits for the next frame, for a timer that is now due or for a condition
+    // that now holds. Called once per frame by the main loop with the frame's length.
+    void advance(std::uint32_t stepMs) {
+        clockMs += stepMs;
+        ready.clear();
+        size_t kept = 0;
+        for (size_t i = 0; i < waiting.size(); ++i) {
+            Waiter& waiter = waiting[i];
+            bool due = waiter.kind == Waiter::Frame || (waiter.kind == Waiter::Timer && clockMs >= waiter.dueMs) ||
+                       (waiter.kind == Waiter::Until && waiter.poll(waiter.context));
+            if (due) {
+                ready.push_back(waiter.handle);
+            } else {
+                waiting[kept++] = waiter;
+            }
+        }
+        waiting.resize(kept);
+        for (size_t i = 0; i < ready.size(); ++i) { // a sequence may clear() the rest
+            ready[i].resume();
+        }
+        reap();
+    }
+
+    // Hands a key press to the oldest sequence waiting for one. False if none was.
+    bool dispatchKey(int key) {
+        for (size_t i = 0; i < waiting.size(); ++i) {
+            if (waiting[i].kind != Waiter::Key) {
+                continue;
+            }
+            Waiter waiter = waiting[i];
+            waiting.erase(waiting.begin() + static_cast<std::ptrdiff_t>(i));
+            *waiter.key = key;
+            waiter.handle.resume();
+            reap();
+            return true;
+        }
+        return false;
+    }
+
+    bool isIdle() const { return roots.empty(); }
+    bool isWaitingForKey() const {
+        for (const Waiter& waiter : waiting) {
+            if (waiter.kind == Waiter::Key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Destroys every sequence where it stands, e.g. on quit.
+    void clear() {
+        waiting.clear();
+        ready.clear();
+        for (Sequence::Handle handle : roots) {
+            handle.destroy();
+        }
+        roots.clear();
+    }
+
+    // co_await sequencer.nextFrame();
+    auto nextFrame() { return Awaiter{this, Waiter::Frame, 0, nullptr, nullptr}; }
+
+    // co_await sequencer.delay(300);
+    auto delay(std::uint32_t ms) { return Awaiter{this, Waiter::Timer, clockMs + ms, nullptr, nullptr}; }
+
+    // co_await sequencer.until([this]() { return warmup.isDone(); }); checked once per frame.
+    template <typename Condition>
+    auto until(Condition condition) {
+        return ConditionAwaiter<Condition>{this, std::move(condition)};
+    }
+
+    // int key = co_await sequencer.keyPress();
+    auto keyPress() { return KeyAwaiter{this, 0}; }
+
+private:
+    struct Waiter {
+        enum Kind { Frame, Timer, Until, Key };
+        Kind kind;
+        std::coroutine_handle<> handle;
+        std::uint64_t dueMs;
+        bool (*poll)(void*);
+        void* context; // the condition, in the coroutine frame
+        int* key;      // where the key press goes, in the coroutine frame
+    };
+
+    struct Awaiter {
+        Sequencer* sequencer;
+        Waiter::Kind kind;
+        std::uint64_t dueMs;
+        bool (*poll)(void*);
+        void* context;
+
+        bool await_ready() const { return kind == Waiter::Timer && sequencer->clockMs >= dueMs; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            sequencer->waiting.push_back({kind, handle, dueMs, poll, context, nullptr});
+        }
+        void await_resume() const {}
+    };
+
+    template <typename Condition>
+    struct ConditionAwaiter {
+        Sequencer* sequencer;
+        Condition condition;
+
+        static bool poll(void* context) { return (*static_cast<Condition*>(context))(); }
+
+        bool await_ready() { return condition(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            sequencer->waiting.push_back({Waiter::Until, handle, 0, &ConditionAwaiter::poll, &condition, nullptr});
+        }
+        void await_resume() const {}
+    };
+
+    struct KeyAwaiter {
+        Sequencer* sequencer;
+        int key;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            sequencer->waiting.push_back({Waiter::Key, handle, 0, nullptr, nullptr, &key});
+        }
+        int await_resume() const { return key; }
+    };
+
+    std::vector<Sequence::Handle> roots;
+    std::vector<Waiter> waiting;
+    std::vector<std::coroutine_handle<>> ready;
+    std::uint64_t clockMs = 0;
+
+    // Frees the sequences that have run to the end.
+    void reap() {
+        size_t kept = 0;
+        for (size_t i = 0; i < roots.size(); ++i) {
+            if (roots[i].done()) {
+                roots[i].destroy();
+            } else {
+                roots[kept++] = roots[i];
+            }
+        }
+        roots.resize(kept);
+    }
+};
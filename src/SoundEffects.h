@@ -0,0 +1,240 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <iostream>
+
+#include "AllocationTracker.h"
+#include "AudioCache.h"
+#include "Log.h"
+#include "core/SoundEffectID.h"
+
+struct SoundEffectDef {
+    const char* path;
+    int priority; // higher wins when all channels are busy
+    int volume;   // 0..MIX_MAX_VOLUME
+    bool ambient; // loops on the ambient channels instead of the effect pool
+};
+
+inline const SoundEffectDef& soundEffectDef(SoundEffectID id) {
+    static const SoundEffectDef defs[static_cast<int>(SoundEffectID::Count)] = {
+        {"../audio/sfx/choice_confirm.wav", 3, 96, false},
+        {"../audio/sfx/page_turn.wav", 2, 80, false},
+        {"../audio/sfx/menu_select.wav", 3, 96, false},
+        {"../audio/sfx/ambient_city.ogg", 1, 48, true},
+        {"../audio/sfx/ambient_sea.ogg", 1, 48, true},
+        {"../audio/sfx/ambient_terrace.ogg", 1, 48, true},
+    };
+    return defs[static_cast<int>(id)];
+}
+
+// Plays preloaded effects on a fixed pool of mixer channels. Every chunk is loaded up front, so
+// a trigger only picks a channel and starts it: nothing is loaded or allocated. When the pool is
+// full the lowest-priority, oldest voice is stolen, or the trigger is dropped if all are higher.
+// Two reserved channels carry the scene's ambient loop and crossfade when it changes.
+class SoundEffects {
+public:
+    struct Stats {
+        Uint64 triggers = 0;
+        Uint64 steals = 0;
+        Uint64 dropped = 0;
+    };
+
+    static constexpr int MaxChannels = 32;
+    static constexpr int AmbientChannels = 2;
+    static constexpr int AmbientFadeMs = 1200;
+
+    // Preloads every effect. Main thread, after the audio device is open.
+    bool init(AudioCache& audioCache, int channelCount) {
+        channelCount = std::max(AmbientChannels + 1, std::min(channelCount, MaxChannels));
+        channels = Mix_AllocateChannels(channelCount);
+        Mix_ReserveChannels(AmbientChannels); // Mix_PlayChannel(-1) never picks the ambient channels
+        bool complete = true;
+        for (int i = 0; i < static_cast<int>(SoundEffectID::Count); ++i) {
+            const SoundEffectDef& def = soundEffectDef(static_cast<SoundEffectID>(i));
+            Mix_Chunk* chunk = audioCache.isEnabled() ? audioCache.loadChunk(def.path) : nullptr; // cooked and memory-mapped
+            if (!chunk) {
+                chunk = Mix_LoadWAV(def.path);
+                owned[i] = chunk != nullptr;
+            }
+            if (!chunk) {
+                logError() << "Failed to load sound effect " << def.path << ": " << Mix_GetError();
+                complete = false;
+                continue;
+            }
+            Mix_VolumeChunk(chunk, def.volume);
+            chunks[i] = chunk;
+        }
+        return complete;
+    }
+
+    // Starts an effect on a pool channel. Returns the channel, or -1 if it was dropped.
+    int play(SoundEffectID id) {
+        Mix_Chunk* chunk = chunkFor(id);
+        if (!chunk) {
+            return -1;
+        }
+        ++stats.triggers;
+        const SoundEffectDef& def = soundEffectDef(id);
+        if (def.ambient) {
+            setAmbient(id);
+            return ambientChannel;
+        }
+
+        int channel = -1;
+        for (int i = AmbientChannels; i < channels; ++i) {
+            if (!Mix_Playing(i)) {
+                channel = i;
+                break;
+            }
+        }
+        if (channel == -1) {
+            channel = stealCandidate(def.priority);
+            if (channel == -1) {
+                ++stats.dropped;
+                return -1;
+            }
+            ++stats.steals;
+            Mix_HaltChannel(channel);
+        }
+        if (Mix_PlayChannel(channel, chunk, 0) == -1) {
+            ++stats.dropped;
+            return -1;
+        }
+        voices[channel] = {def.priority, ++sequence};
+        return channel;
+    }
+
+    // Crossfades the ambient loop to another effect, or fades it out for SoundEffectID::None.
+    void setAmbient(SoundEffectID id) {
+        if (id == currentAmbient) {
+            return;
+        }
+        if (currentAmbient != SoundEffectID::None) {
+            Mix_FadeOutChannel(ambientChannel, AmbientFadeMs);
+        }
+        currentAmbient = id;
+        Mix_Chunk* chunk = chunkFor(id);
+        if (!chunk) {
+            return;
+        }
+        ambientChannel = (ambientChannel + 1) % AmbientChannels;
+        Mix_HaltChannel(ambientChannel);
+        Mix_FadeInChannel(ambientChannel, chunk, -1, AmbientFadeMs);
+    }
+
+    void stopAll() {
+        Mix_HaltChannel(-1);
+        currentAmbient = SoundEffectID::None;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+    // Decoded sample bytes of an effect, 0 if it did not load.
+    Uint64 chunkBytes(SoundEffectID id) const {
+        Mix_Chunk* chunk = chunkFor(id);
+        return chunk ? chunk->alen : 0;
+    }
+
+    void clear() {
+        stopAll();
+        for (int i = 0; i < static_cast<int>(SoundEffectID::Count); ++i) {
+            if (owned[i]) {
+                Mix_FreeChunk(chunks[i]); // cooked chunks belong to the AudioCache
+            }
+            chunks[i] = nullptr;
+            owned[i] = false;
+        }
+    }
+
+    // True when every effect the stress test fires has loaded.
+    bool canStress() const {
+        for (SoundEffectID id : stressEffects) {
+            if (!chunkFor(id)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Fires random pool effects at a fixed rate for a while and reports how triggers held up
+    // (--sfx-stress). False if a trigger allocated, when allocations are tracked.
+    bool runStressTest(int seconds, int triggersPerSecond) {
+        Stats before = stats;
+        AllocationSnapshot allocatedBefore = allocations().snapshot();
+        Uint64 frequency = SDL_GetPerformanceFrequency();
+        Uint64 slowest = 0;
+        Uint64 total = 0;
+        int fired = 0;
+        Uint32 start = SDL_GetTicks();
+        Uint32 seed = 12345;
+        while (SDL_GetTicks() - start < static_cast<Uint32>(seconds) * 1000) {
+            int due = static_cast<int>(static_cast<Uint64>(SDL_GetTicks() - start) * triggersPerSecond / 1000);
+            for (; fired < due; ++fired) {
+                seed = seed * 1664525 + 1013904223;
+                SoundEffectID id = stressEffects[(seed >> 16) % (sizeof(stressEffects) / sizeof(stressEffects[0]))];
+                PAMPLEMOUSSE_ALLOCATION_SCOPE(Audio);
+                Uint64 t0 = SDL_GetPerformanceCounter();
+                play(id);
+                Uint64 elapsed = SDL_GetPerformanceCounter() - t0;
+                total += elapsed;
+                slowest = std::max(slowest, elapsed);
+            }
+            SDL_Delay(1);
+        }
+        double averageUs = fired ? total * 1e6 / frequency / fired : 0.0;
+        std::cout << "SFX stress: " << fired << " triggers in " << seconds << " s on " << channels - AmbientChannels << " channels, "
+                  << stats.steals - before.steals << " stolen, " << stats.dropped - before.dropped << " dropped, "
+                  << averageUs << " us avg, " << slowest * 1e6 / frequency << " us max per trigger" << std::endl;
+#ifdef PAMPLEMOUSSE_TRACK_ALLOCATIONS
+        // Only the triggers run under the Audio tag on this thread.
+        Uint64 allocated = (allocations().snapshot() - allocatedBefore).counts[static_cast<int>(AllocationSubsystem::Audio)];
+        if (allocated) {
+            logError() << "SFX stress: triggers allocated " << allocated << " times";
+            return false;
+        }
+#else
+        (void)allocatedBefore;
+#endif
+        return true;
+    }
+
+private:
+    struct Voice {
+        int priority;
+        Uint64 started;
+    };
+
+    static constexpr SoundEffectID stressEffects[3] = {SoundEffectID::ChoiceConfirm, SoundEffectID::PageTurn, SoundEffectID::MenuSelect};
+
+    Mix_Chunk* chunks[static_cast<int>(SoundEffectID::Count)] = {};
+    bool owned[static_cast<int>(SoundEffectID::Count)] = {};
+    Voice voices[MaxChannels] = {};
+    int channels = 0;
+    int ambientChannel = 0;
+    SoundEffectID currentAmbient = SoundEffectID::None;
+    Uint64 sequence = 0;
+    Stats stats;
+
+    Mix_Chunk* chunkFor(SoundEffectID id) const {
+        int index = static_cast<int>(id);
+        return index >= 0 && index < static_cast<int>(SoundEffectID::Count) ? chunks[index] : nullptr;
+    }
+
+    // Lowest-priority voice not above the given priority, oldest first; -1 if every voice outranks it.
+    int stealCandidate(int priority) const {
+        int best = -1;
+        for (int i = AmbientChannels; i < channels; ++i) {
+            const Voice& voice = voices[i];
+            if (voice.priority > priority) {
+                continue;
+            }
+            if (best == -1 || voice.priority < voices[best].priority ||
+                (voice.priority == voices[best].priority && voice.started < voices[best].started)) {
+                best = i;
+            }
+        }
+        return best;
+    }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Stats.h"
+#include "Trace.h"
+
+// Start-up phases on every thread that takes part, and the time from the start of init to the
+// first presented frame. Phases overlap when they run on workers, so the report shows both the
+// sum of the phases and the wall time they took together.
+class StartupProfiler {
+public:
+    struct Phase {
+        const char* name;
+        const char* thread;
+        Uint64 start;
+        Uint64 end;
+    };
+
+    void begin() {
+        origin = SDL_GetPerformanceCounter();
+        firstFrame = 0;
+    }
+
+    void record(const char* name, const char* thread, Uint64 start, Uint64 end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        phases.push_back({name, thread, start, end});
+    }
+
+    // True the first time only, so the caller reports once.
+    bool markFirstFrame() {
+        if (firstFrame || !origin) {
+            return false;
+        }
+        firstFrame = SDL_GetPerformanceCounter();
+        return true;
+    }
+
+    double timeToFirstFrameMs() const { return firstFrame ? ticksToMs(firstFrame - origin) : 0.0; }
+
+    std::string report() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1);
+        out << "Start-up (ms from the start of init)\n";
+        out << std::left << std::setw(22) << "phase" << std::setw(16) << "thread" << std::right << std::setw(9) << "start"
+            << std::setw(9) << "took" << "\n";
+        double total = 0.0;
+        Uint64 lastEnd = origin;
+        for (const Phase& phase : phases) {
+            double took = ticksToMs(phase.end - phase.start);
+            total += took;
+            lastEnd = std::max(lastEnd, phase.end);
+            out << std::left << std::setw(22) << phase.name << std::setw(16) << phase.thread << std::right << std::setw(9)
+                << ticksToMs(phase.start - origin) << std::setw(9) << took << "\n";
+        }
+        out << "Phases took " << total << " ms in total, " << ticksToMs(lastEnd - origin) << " ms of wall time\n";
+        out << "Time to first frame: " << timeToFirstFrameMs() << " ms\n";
+        return out.str();
+    }
+
+private:
+    mutable std::mutex mutex; // phases are recorded from the init workers
+    std::vector<Phase> phases;
+    Uint64 origin = 0;
+    Uint64 firstFrame = 0;
+};
+
+// Times the enclosing scope as a start-up phase, and as a trace span while tracing is on.
+class StartupPhase {
+public:
+    StartupPhase(StartupProfiler& profiler, const char* name, const char* thread)
+        : profiler(profiler), name(name), thread(thread), trace(name, "startup"), start(SDL_GetPerformanceCounter()) {}
+    ~StartupPhase() { profiler.record(name, thread, start, SDL_GetPerformanceCounter()); }
+    StartupPhase(const StartupPhase&) = delete;
+    StartupPhase& operator=(const StartupPhase&) = delete;
+
+private:
+    StartupProfiler& profiler;
+    const char* name;
+    const char* thread;
+    TraceScope trace;
+    Uint64 start;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Fixed window of the most recent samples with min, average, max and percentiles over it.
+class RollingStat {
+public:
+    static constexpr int WindowSize = 512;
+
+    void add(double value) {
+        samples[next] = value;
+        next = (next + 1) % WindowSize;
+        filled = std::min(filled + 1, WindowSize);
+        latest = value;
+        ++total;
+    }
+
+    Uint64 count() const { return total; }
+    double last() const { return latest; }
+
+    double min() const { return filled ? *std::min_element(samples, samples + filled) : 0.0; }
+    double max() const { return filled ? *std::max_element(samples, samples + filled) : 0.0; }
+
+    double average() const {
+        double sum = 0.0;
+        for (int i = 0; i < filled; ++i) {
+            sum += samples[i];
+        }
+        return filled ? sum / filled : 0.0;
+    }
+
+    // p in [0, 1]; sorts a copy of the window, so call it when reporting rather than per sample.
+    double percentile(double p) const {
+        if (!filled) {
+            return 0.0;
+        }
+        double sorted[WindowSize];
+        std::copy(samples, samples + filled, sorted);
+        int index = std::min(filled - 1, static_cast<int>(p * filled));
+        std::nth_element(sorted, sorted + index, sorted + filled);
+        return sorted[index];
+    }
+
+    void clear() {
+        filled = 0;
+        next = 0;
+        total = 0;
+        latest = 0.0;
+    }
+
+private:
+    double samples[WindowSize] = {};
+    int next = 0;
+    int filled = 0;
+    Uint64 total = 0;
+    double latest = 0.0;
+};
+
+// Named timing series and counters shown together: frame timing, audio callback timing and
+// anything else worth watching. Main thread only; other threads hand samples over first.
+class StatsRegistry {
+public:
+    StatsRegistry() : id(nextID().fetch_add(1) + 1) {}
+    StatsRegistry(const StatsRegistry&) = delete;
+    StatsRegistry& operator=(const StatsRegistry&) = delete;
+
+    // Never reused, so a cached series can tell which registry it came from.
+    Uint64 getID() const { return id; }
+
+    // Looked up by the literal's address after the first call, so no string work; timed scopes
+    // skip even that lookup by caching the result (StatSite).
+    RollingStat& series(const char* name) {
+        auto it = seriesByLiteral.find(name);
+        if (it != seriesByLiteral.end()) {
+            return *it->second;
+        }
+        RollingStat& stat = seriesByName[name];
+        seriesByLiteral[name] = &stat;
+        return stat;
+    }
+
+    // Counters are looked up by literal too, so updating them every frame does not allocate.
+    Uint64& counterSlot(const char* name) {
+        auto it = countersByLiteral.find(name);
+        if (it != countersByLiteral.end()) {
+            return *it->second;
+        }
+        Uint64& value = counters[name];
+        countersByLiteral[name] = &value;
+        return value;
+    }
+
+    void add(const char* name, double value) { series(name).add(value); }
+    void count(const char* name, Uint64 delta = 1) { counterSlot(name) += delta; }
+    void set(const char* name, Uint64 value) { counterSlot(name) = value; }
+
+    const RollingStat* find(const std::string& name) const {
+        auto it = seriesByName.find(name);
+        return it == seriesByName.end() ? nullptr : &it->second;
+    }
+
+    Uint64 counter(const std::string& name) const {
+        auto it = counters.find(name);
+        return it == counters.end() ? 0 : it->second;
+    }
+
+    std::string report() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "Timing (ms over the last " << RollingStat::WindowSize << " samples)\n";
+        out << std::left << std::setw(22) << "series" << std::right << std::setw(9) << "count" << std::setw(9) << "min"
+            << std::setw(9) << "avg" << std::setw(9) << "p99" << std::setw(9) << "max" << "\n";
+        for (const auto& entry : seriesByName) {
+            const RollingStat& stat = entry.second;
+            out << std::left << std::setw(22) << entry.first << std::right << std::setw(9) << stat.count()
+                << std::setw(9) << stat.min() << std::setw(9) << stat.average() << std::setw(9) << stat.percentile(0.99)
+                << std::setw(9) << stat.max() << "\n";
+        }
+        for (const auto& entry : counters) {
+            out << std::left << std::setw(22) << entry.first << std::right << std::setw(9) << entry.second << "\n";
+        }
+        return out.str();
+    }
+
+private:
+    Uint64 id;
+    std::map<std::string, RollingStat> seriesByName; // ordered so reports are stable
+    std::unordered_map<const char*, RollingStat*> seriesByLiteral;
+    std::map<std::string, Uint64> counters;
+    std::unordered_map<const char*, Uint64*> countersByLiteral;
+
+    static std::atomic<Uint64>& nextID() {
+        static std::atomic<Uint64> counter{0};
+        return counter;
+    }
+};
+
+inline double ticksToMs(Uint64 ticks) {
+    return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// PAMPLEMOUSSE_TIME_SCOPE(stats, "name") adds the time until the end of the enclosing scope to
+// stats.series("name"). Each use keeps the series it resolved to in a static StatSite, so once
+// warm a timed scope is a registry ID compare, two counter reads and one array store. Without
+// PAMPLEMOUSSE_PROFILING it compiles to nothing.
+#ifdef PAMPLEMOUSSE_PROFILING
+// The series one timed scope writes to, per thread, looked up again only if the registry changes.
+struct StatSite {
+    Uint64 registry = 0;
+    RollingStat* stat = nullptr;
+
+    RollingStat& resolve(StatsRegistry& stats, const char* name) {
+        if (registry != stats.getID()) {
+            stat = &stats.series(name);
+            registry = stats.getID();
+        }
+        return *stat;
+    }
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(RollingStat& stat) : stat(stat), start(SDL_GetPerformanceCounter()) {}
+    ~ScopedTimer() { stat.add(ticksToMs(SDL_GetPerformanceCounter() - start)); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    RollingStat& stat;
+    Uint64 start;
+};
+
+#define PAMPLEMOUSSE_TIMER_NAME2(line) scopedTimer##line
+#define PAMPLEMOUSSE_TIMER_NAME(line) PAMPLEMOUSSE_TIMER_NAME2(line)
+#define PAMPLEMOUSSE_SITE_NAME2(line) statSite##line
+#define PAMPLEMOUSSE_SITE_NAME(line) PAMPLEMOUSSE_SITE_NAME2(line)
+#define PAMPLEMOUSSE_TIME_SCOPE(stats, name)                              \
+    static thread_local StatSite PAMPLEMOUSSE_SITE_NAME(__LINE__);        \
+    ScopedTimer PAMPLEMOUSSE_TIMER_NAME(__LINE__)(PAMPLEMOUSSE_SITE_NAME(__LINE__).resolve((stats), name))
+#else
+#define PAMPLEMOUSSE_TIME_SCOPE(stats, name) ((void)0)
+#endif
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "AudioCache.h"
+#include "RingBuffer.h"
+
+// Streams a cooked PCM file through a lock-free ring buffer. A reader thread keeps the ring
+// topped up from disk; the audio callback only copies out of it.
+class PcmStream {
+public:
+    ~PcmStream() { stop(); }
+
+    // Opens a cooked file and fills the first block synchronously, so playback can start at once.
+    // A prefix already read from the start of the PCM (whole frames) seeds the ring instead.
+    bool open(const AudioCache& cache, const std::string& cookedPath, bool shouldLoop, size_t ringBytes,
+              const std::vector<Uint8>* prefix = nullptr) {
+        CookedAudioHeader header;
+        if (!cache.readHeader(cookedPath, header) || header.dataBytes == 0) {
+            return false;
+        }
+        fd = ::open(cookedPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        frameBytes = static_cast<size_t>(cache.frameBytes());
+        dataBytes = header.dataBytes;
+        loop = shouldLoop;
+        ring.reset(ringBytes);
+        block.resize(BlockBytes);
+        if (prefix && !prefix->empty() && prefix->size() <= dataBytes) {
+            position = ring.write(prefix->data(), prefix->size());
+            if (position >= dataBytes) {
+                position = 0;
+                endOfData = !loop;
+            }
+        } else {
+            fillOnce();
+        }
+        reader = std::thread([this]() { readerLoop(); });
+        return true;
+    }
+
+    // Audio thread. Copies whole frames only and returns the number of bytes copied.
+    size_t read(Uint8* out, size_t bytes) {
+        size_t available = ring.readable();
+        size_t wanted = std::min(bytes, available - available % frameBytes);
+        return ring.read(out, wanted);
+    }
+
+    bool isFinished() const { return endOfData.load() && ring.readable() < frameBytes; }
+
+    void stop() {
+        stopping = true;
+        if (reader.joinable()) {
+            reader.join();
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+private:
+    static constexpr size_t BlockBytes = 32 * 1024;
+
+    int fd = -1;
+    size_t frameBytes = 4;
+    Uint64 dataBytes = 0;
+    Uint64 position = 0;
+    bool loop = false;
+    SpscByteRing ring;
+    std::vector<Uint8> block;
+    std::thread reader;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> endOfData{false};
+
+    // Reads one block into the ring if there is room. Returns false once there is nothing left to read.
+    bool fillOnce() {
+        size_t room = ring.writable();
+        if (room < frameBytes) {
+            return true;
+        }
+        size_t wanted = static_cast<size_t>(std::min<Uint64>(std::min(room, BlockBytes), dataBytes - position));
+        wanted -= wanted % frameBytes;
+        ssize_t got = pread(fd, block.data(), wanted, static_cast<off_t>(sizeof(CookedAudioHeader) + position));
+        if (got <= 0) {
+            endOfData = true;
+            return false;
+        }
+        ring.write(block.data(), static_cast<size_t>(got));
+        position += static_cast<Uint64>(got);
+        if (position >= dataBytes) {
+            if (!loop) {
+                endOfData = true;
+                return false;
+            }
+            position = 0;
+        }
+        return true;
+    }
+
+    void readerLoop() {
+        while (!stopping && !endOfData) {
+            if (ring.writable() < BlockBytes) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
+            }
+            if (!fillOnce()) {
+                break;
+            }
+        }
+    }
+};
+
+// Custom mixer stage installed with Mix_HookMusic (themes) or run from the AudioMonitor's post-mix
+// hook (voice-over, mixed on top of everything else). Plays cooked audio streamed by PcmStream and crossfades between the
+// outgoing and incoming tracks. The main thread talks to the audio
+// callback through lock-free queues: commands go in, finished streams come back to be freed,
+// so the callback never locks, allocates or frees.
+class StreamMixer {
+public:
+    struct Stats {
+        std::atomic<Uint64> callbacks{0};
+        std::atomic<Uint64> underruns{0};
+    };
+
+    enum class Stage { Music, PostMix };
+
+    void init(const AudioCache& cache, int deviceBufferFrames, Stage mixStage = Stage::Music) {
+        stage = mixStage;
+        format = cache.getFormat();
+        frameBytes = cache.frameBytes();
+        frequency = cache.getFrequency();
+        scratch.assign(static_cast<size_t>(deviceBufferFrames) * frameBytes, 0);
+    }
+
+    void install() {
+        if (!installed) {
+            if (stage == Stage::Music) {
+                Mix_HookMusic(mixCallback, this);
+            }
+            installed = true; // a post-mix stage is already being called by its owner
+        }
+    }
+
+    // Unhooks the stage (so Mix_Music playback works again) and frees every stream. The owner of a
+    // post-mix stage must stop calling mix() first.
+    void uninstall() {
+        if (!installed) {
+            return;
+        }
+        if (stage == Stage::Music) {
+            Mix_HookMusic(nullptr, nullptr); // waits for a callback in flight
+        }
+        installed = false;
+        Command command;
+        while (commands.pop(command)) {
+            delete command.stream;
+        }
+        for (Voice& voice : voices) {
+            delete voice.stream;
+            voice.stream = nullptr;
+        }
+        audibleVoices = 0;
+        fadingOut = false;
+        update();
+    }
+
+    // Starts a stream, crossfading from whatever is playing over fadeMs. Takes ownership.
+    void play(PcmStream* stream, int fadeMs) {
+        install();
+        fadingOut = false;
+        pushCommand({Command::Play, stream, msToFrames(fadeMs)});
+    }
+
+    void fadeOut(int fadeMs) {
+        if (installed && !fadingOut) {
+            fadingOut = true;
+            pushCommand({Command::FadeOut, nullptr, msToFrames(fadeMs)});
+        }
+    }
+
+    bool isInstalled() const { return installed; }
+    bool isPlaying() const { return installed && (!commands.empty() || audibleVoices.load() > 0); }
+    bool isFadingOut() const { return fadingOut; }
+
+    // Frees the streams the audio thread has finished with. Main thread, once per frame.
+    void update() {
+        PcmStream* stream;
+        while (retired.pop(stream)) {
+            delete stream;
+        }
+    }
+
+    const Stats& getStats() const { return stats; }
+
+    // Audio thread. Mixes every voice into the device buffer.
+    void mix(Uint8* stream, int len) {
+        ++stats.callbacks;
+        Command command;
+        while (commands.pop(command)) {
+            apply(command);
+        }
+
+        int audible = 0;
+        for (Voice& voice : voices) {
+            if (!voice.stream) {
+                continue;
+            }
+            int offset = 0;
+            bool starved = false;
+            while (offset < len && !starved) {
+                size_t piece = std::min(static_cast<size_t>(len - offset), scratch.size());
+                size_t got = voice.stream->read(scratch.data(), piece);
+                if (got > 0 && voice.gain > 0.0f) {
+                    int volume = static_cast<int>(voice.gain * MIX_MAX_VOLUME + 0.5f);
+                    SDL_MixAudioFormat(stream + offset, scratch.data(), format, static_cast<Uint32>(got), volume);
+                }
+                offset += static_cast<int>(got);
+                starved = got < piece;
+            }
+            if (starved && !voice.stream->isFinished()) {
+                ++stats.underruns;
+            }
+
+            voice.gain = std::min(1.0f, voice.gain + voice.gainStep * (len / frameBytes));
+            if (voice.gain <= 0.0f || voice.stream->isFinished()) {
+                retire(voice);
+                continue;
+            }
+            ++audible;
+        }
+        audibleVoices = audible;
+    }
+
+private:
+    struct Command {
+        enum Type { Play, FadeOut } type;
+        PcmStream* stream;
+        int fadeFrames;
+    };
+
+    struct Voice {
+        PcmStream* stream = nullptr;
+        float gain = 0.0f;
+        float gainStep = 0.0f; // per frame
+    };
+
+    static const int MaxVoices = 4;
+
+    Stage stage = Stage::Music;
+    Uint16 format = AUDIO_S16SYS;
+    int frameBytes = 4;
+    int frequency = 44100;
+    bool installed = false;
+    bool fadingOut = false;               // main thread's view: the last command was a fade-out
+    Voice voices[MaxVoices];              // audio thread only while installed
+    SpscQueue<Command, 16> commands;      // main -> audio
+    SpscQueue<PcmStream*, 32> retired;    // audio -> main
+    std::vector<Uint8> scratch;
+    std::atomic<int> audibleVoices{0};
+    Stats stats;
+
+    int msToFrames(int ms) const { return static_cast<int>(static_cast<Sint64>(ms) * frequency / 1000); }
+
+    void pushCommand(const Command& command) {
+        while (!commands.push(command)) {
+            SDL_Delay(1); // only if the callback has stalled for 16 commands
+        }
+    }
+
+    static void SDLCALL mixCallback(void* udata, Uint8* stream, int len) {
+        static_cast<StreamMixer*>(udata)->mix(stream, len);
+    }
+
+    void apply(const Command& command) {
+        float step = command.fadeFrames > 0 ? 1.0f / command.fadeFrames : 1.0f;
+        for (Voice& voice : voices) {
+            if (voice.stream) {
+                voice.gainStep = -step;
+            }
+        }
+        if (command.type != Command::Play) {
+            return;
+        }
+        Voice* slot = nullptr;
+        for (Voice& voice : voices) {
+            if (!voice.stream) {
+                slot = &voice;
+                break;
+            }
+        }
+        if (!slot) {
+            // Every slot is busy fading: drop the quietest.
+            slot = &voices[0];
+            for (Voice& voice : voices) {
+                if (voice.gain < slot->gain) {
+                    slot = &voice;
+                }
+            }
+            retire(*slot);
+        }
+        slot->stream = command.stream;
+        slot->gain = command.fadeFrames > 0 ? 0.0f : 1.0f;
+        slot->gainStep = step;
+    }
+
+    void retire(Voice& voice) {
+        if (retired.push(voice.stream)) {
+            voice.stream = nullptr;
+        } else {
+            voice.gainStep = -1.0f; // queue full: keep it silent and retry next callback
+        }
+    }
+};
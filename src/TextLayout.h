@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SDL2/SDL_ttf.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One wrapped line of text, offset from the top of its block
+struct TextLine {
+    std::string text;
+    int yOffset;
+};
+
+// Result of word-wrapping a text block at a given width
+struct TextLayout {
+    std::vector<TextLine> lines;
+};
+
+// Word-wraps a text block to lineWidth pixels: explicit newlines start a new line, and a word
+// moves to the next line when it would overflow. Measures every candidate line with the font.
+inline TextLayout wrapText(TTF_Font* font, const std::string& text, int lineWidth) {
+    TextLayout layout;
+    std::istringstream stream(text);
+    std::string line;
+    int yOffset = 0;
+
+    while (std::getline(stream, line)) {
+        std::istringstream wordStream(line);
+        std::string currentLine;
+        std::string word;
+
+        while (wordStream >> word) {
+            std::string testLine = currentLine + (currentLine.empty() ? "" : " ") + word;
+            int textWidth, textHeight;
+            TTF_SizeText(font, testLine.c_str(), &textWidth, &textHeight);
+            if (textWidth > lineWidth) {
+                layout.lines.push_back({currentLine, yOffset});
+                yOffset += textHeight + 10;
+                currentLine = word;
+            } else {
+                currentLine = testLine;
+            }
+        }
+
+        if (!currentLine.empty()) {
+            int textWidth, textHeight;
+            TTF_SizeText(font, currentLine.c_str(), &textWidth, &textHeight);
+            layout.lines.push_back({currentLine, yOffset});
+            yOffset += textHeight + 10;
+        }
+    }
+    return layout;
+}
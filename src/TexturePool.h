@@ -0,0 +1,247 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "ImageDecoder.h"
+#include "Log.h"
+
+// Pool of reusable streaming textures, bucketed by pixel format and size class.
+// Pixels are uploaded into recycled textures instead of creating a new texture per draw.
+class TexturePool {
+public:
+    struct Stats {
+        Uint64 hits = 0;             // acquisitions served from a free list
+        Uint64 misses = 0;           // acquisitions that had to create a texture
+        Uint64 uploads = 0;
+        Uint64 bytesResident = 0;    // bytes held by every texture the pool owns
+        Uint64 texturesResident = 0;
+        Uint64 lastFrameMisses = 0;  // textures created during the last completed frame
+    };
+
+    void init(SDL_Renderer* targetRenderer) {
+        renderer = targetRenderer;
+        SDL_RendererInfo info;
+        supportedFormats.clear();
+        if (SDL_GetRendererInfo(renderer, &info) == 0) {
+            supportedFormats.assign(info.texture_formats, info.texture_formats + info.num_texture_formats);
+        }
+    }
+
+    // Returns a texture of at least w x h pixels; only the top-left w x h region is meaningful.
+    SDL_Texture* acquire(Uint32 format, int w, int h) {
+        Uint64 key = bucketKey(format, sizeClass(w), sizeClass(h));
+        std::vector<SDL_Texture*>& freeList = freeLists[key];
+        if (!freeList.empty()) {
+            SDL_Texture* texture = freeList.back();
+            freeList.pop_back();
+            ++stats.hits;
+            return texture;
+        }
+
+        int classW = sizeClass(w);
+        int classH = sizeClass(h);
+        SDL_Texture* texture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STREAMING, classW, classH);
+        if (!texture) {
+            logError() << "Failed to create pooled texture: " << SDL_GetError();
+            return nullptr;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        Uint64 bytes = textureBytes(format, classW, classH);
+        owned[texture] = {key, bytes};
+        ++stats.misses;
+        ++frameMisses;
+        stats.bytesResident += bytes;
+        stats.texturesResident = owned.size();
+        return texture;
+    }
+
+    void release(SDL_Texture* texture) {
+        auto it = owned.find(texture);
+        if (it == owned.end()) {
+            return;
+        }
+        freeLists[it->second.key].push_back(texture);
+    }
+
+    // GPU bytes held by a pooled texture (its full size class, not just the used region).
+    Uint64 residentBytes(SDL_Texture* texture) const {
+        auto it = owned.find(texture);
+        return it == owned.end() ? 0 : it->second.bytes;
+    }
+
+    // Destroys every texture currently sitting in a free list, giving the memory back.
+    void trimFree() {
+        for (auto& bucket : freeLists) {
+            for (SDL_Texture* texture : bucket.second) {
+                auto it = owned.find(texture);
+                stats.bytesResident -= it->second.bytes;
+                owned.erase(it);
+                SDL_DestroyTexture(texture);
+            }
+            bucket.second.clear();
+        }
+        stats.texturesResident = owned.size();
+    }
+
+    // Uploads a surface into a frame-scoped pooled texture. Returns nullptr on failure.
+    SDL_Texture* uploadForFrame(SDL_Surface* surface) {
+        SDL_Texture* texture = createFromSurface(surface);
+        if (texture) {
+            frameLeases.push_back(texture);
+        }
+        return texture;
+    }
+
+    // Uploads a surface into a pooled texture held until release(). Returns nullptr on failure.
+    SDL_Texture* createFromSurface(SDL_Surface* surface) {
+        SDL_Surface* converted = nullptr;
+        Uint32 format = uploadFormatFor(surface->format->format);
+        if (format != surface->format->format) {
+            converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+            if (!converted) {
+                logError() << "Failed to convert surface for upload: " << SDL_GetError();
+                return nullptr;
+            }
+        }
+        SDL_Surface* source = converted ? converted : surface;
+        SDL_Texture* texture = acquire(format, source->w, source->h);
+        if (texture && !upload(texture, source)) {
+            release(texture);
+            texture = nullptr;
+        }
+        if (converted) {
+            SDL_FreeSurface(converted);
+        }
+        return texture;
+    }
+
+    // Uploads IYUV planes into a pooled IYUV texture held until release(). Returns nullptr on failure.
+    SDL_Texture* createFromYUV(const DecodedImage& image) {
+        SDL_Texture* texture = acquire(SDL_PIXELFORMAT_IYUV, image.w, image.h);
+        if (!texture) {
+            return nullptr;
+        }
+        SDL_Rect rect = {0, 0, image.w, image.h};
+        if (SDL_UpdateYUVTexture(texture, &rect, image.yPlane(), image.pitch, image.uPlane(), image.chromaWidth(),
+                                 image.vPlane(), image.chromaWidth()) < 0) {
+            logError() << "Failed to upload YUV texture: " << SDL_GetError();
+            release(texture);
+            return nullptr;
+        }
+        ++stats.uploads;
+        return texture;
+    }
+
+    // Copies the surface pixels into the top-left corner of a pooled texture of the same format.
+    bool upload(SDL_Texture* texture, SDL_Surface* surface) {
+        SDL_Rect rect = {0, 0, surface->w, surface->h};
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(texture, &rect, &pixels, &pitch) < 0) {
+            logError() << "Failed to lock pooled texture: " << SDL_GetError();
+            return false;
+        }
+        if (SDL_MUSTLOCK(surface)) {
+            SDL_LockSurface(surface);
+        }
+        const Uint8* src = static_cast<const Uint8*>(surface->pixels);
+        Uint8* dst = static_cast<Uint8*>(pixels);
+        size_t rowBytes = static_cast<size_t>(surface->w) * surface->format->BytesPerPixel;
+        for (int row = 0; row < surface->h; ++row) {
+            std::memcpy(dst + row * pitch, src + row * surface->pitch, rowBytes);
+        }
+        if (SDL_MUSTLOCK(surface)) {
+            SDL_UnlockSurface(surface);
+        }
+        SDL_UnlockTexture(texture);
+        ++stats.uploads;
+        return true;
+    }
+
+    // Returns frame-scoped textures to their free lists. Call right after SDL_RenderPresent.
+    void endFrame() {
+        for (SDL_Texture* texture : frameLeases) {
+            release(texture);
+        }
+        frameLeases.clear();
+        stats.lastFrameMisses = frameMisses;
+        frameMisses = 0;
+    }
+
+    // Picks the surface's own format when the renderer can take it directly, ARGB8888 otherwise.
+    Uint32 uploadFormatFor(Uint32 surfaceFormat) const {
+        if (!SDL_ISPIXELFORMAT_INDEXED(surfaceFormat) && !SDL_ISPIXELFORMAT_FOURCC(surfaceFormat)) {
+            for (Uint32 supported : supportedFormats) {
+                if (supported == surfaceFormat) {
+                    return surfaceFormat;
+                }
+            }
+        }
+        return SDL_PIXELFORMAT_ARGB8888;
+    }
+
+    bool supportsFormat(Uint32 format) const {
+        for (Uint32 supported : supportedFormats) {
+            if (supported == format) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+    void clear() {
+        for (auto& entry : owned) {
+            SDL_DestroyTexture(entry.first);
+        }
+        owned.clear();
+        freeLists.clear();
+        frameLeases.clear();
+        stats.bytesResident = 0;
+        stats.texturesResident = 0;
+    }
+
+    static int sizeClass(int size) {
+        // Coarse steps keep the bucket count small: 64-pixel granularity for small sizes,
+        // a quarter of the next power of two above that.
+        if (size < 1) {
+            size = 1;
+        }
+        int pow2 = 1;
+        while (pow2 < size) {
+            pow2 <<= 1;
+        }
+        int step = pow2 / 4 > 64 ? pow2 / 4 : 64;
+        return ((size + step - 1) / step) * step;
+    }
+
+private:
+    SDL_Renderer* renderer = nullptr;
+    std::vector<Uint32> supportedFormats;
+    std::unordered_map<Uint64, std::vector<SDL_Texture*>> freeLists;
+    struct Owned {
+        Uint64 key;
+        Uint64 bytes;
+    };
+
+    std::unordered_map<SDL_Texture*, Owned> owned;
+    std::vector<SDL_Texture*> frameLeases;
+    Uint64 frameMisses = 0;
+    Stats stats;
+
+    static Uint64 bucketKey(Uint32 format, int w, int h) {
+        return (static_cast<Uint64>(format) << 32) | (static_cast<Uint64>(w) << 16) | static_cast<Uint64>(h);
+    }
+
+    static Uint64 textureBytes(Uint32 format, int w, int h) {
+        if (SDL_ISPIXELFORMAT_FOURCC(format)) {
+            // Planar YUV formats: full-resolution luma plus two quarter-resolution chroma planes.
+            return static_cast<Uint64>(w) * h * 3 / 2;
+        }
+        return static_cast<Uint64>(w) * h * SDL_BYTESPERPIXEL(format);
+    }
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Log.h"
+#include "RingBuffer.h"
+
+// One finished span. Names and categories must be string literals: nothing is copied.
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    Uint64 start; // performance counter ticks
+    Uint64 end;
+    int sceneID;
+    int chapterID;
+};
+
+// Records spans from any thread into a Chrome/Perfetto trace-event JSON file. Each thread
+// writes to its own lock-free queue; a flusher thread drains them to disk every few tens of
+// milliseconds, so recording a span never locks, allocates or touches the file. Tracing stops
+// by itself after the requested duration.
+class TraceRecorder {
+public:
+    static constexpr size_t EventsPerThread = 4096;
+
+    bool start(const std::string& path, int seconds) {
+        stop();
+        file = fopen(path.c_str(), "w");
+        if (!file) {
+            logError() << "Cannot write trace to " << path;
+            return false;
+        }
+        std::fputs("{\"traceEvents\":[\n", file);
+        firstEvent = true;
+        written = 0;
+        dropped = 0;
+        origin = SDL_GetPerformanceCounter();
+        deadline = origin + static_cast<Uint64>(seconds) * SDL_GetPerformanceFrequency();
+        tracePath = path;
+        active.store(true, std::memory_order_release);
+        flusher = std::thread([this]() { flushLoop(); });
+        return true;
+    }
+
+    // Stops recording early; the flusher writes what is left and closes the file.
+    void stop() {
+        active.store(false, std::memory_order_release);
+        if (flusher.joinable()) {
+            flusher.join();
+        }
+    }
+
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    // Scene and chapter attached to spans that do not name their own.
+    void setContext(int sceneID, int chapterID) {
+        currentScene.store(sceneID, std::memory_order_relaxed);
+        currentChapter.store(chapterID, std::memory_order_relaxed);
+    }
+
+    int contextScene() const { return currentScene.load(std::memory_order_relaxed); }
+    int contextChapter() const { return currentChapter.load(std::memory_order_relaxed); }
+
+    // Labels the calling thread's track in the trace viewer. The name must be a literal.
+    void nameThread(const char* name) { localBuffer()->name.store(name, std::memory_order_release); }
+
+    void record(const TraceEvent& event) {
+        if (!localBuffer()->events.push(event)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct ThreadBuffer {
+        SpscQueue<TraceEvent, EventsPerThread> events;
+        int tid = 0;
+        std::atomic<const char*> name{nullptr};
+        bool named = false;                // flusher only: metadata written
+        std::atomic<bool> released{false}; // its thread has exited; reusable once drained
+    };
+
+    // Hands the buffer back when the thread exits, so short-lived worker threads do not pile up buffers.
+    struct LocalHandle {
+        ThreadBuffer* buffer = nullptr;
+        ~LocalHandle() {
+            if (buffer) {
+                buffer->released.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    std::atomic<bool> active{false};
+    std::atomic<int> currentScene{-1};
+    std::atomic<int> currentChapter{-1};
+    std::atomic<Uint64> dropped{0};
+    std::mutex buffersMutex; // guards the list, taken once per new thread and per flush
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::thread flusher;
+    FILE* file = nullptr;
+    std::string tracePath;
+    bool firstEvent = true;
+    Uint64 written = 0;
+    Uint64 origin = 0;
+    Uint64 deadline = 0;
+
+    ThreadBuffer* localBuffer() {
+        static thread_local LocalHandle handle;
+        if (!handle.buffer) {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+                if (buffer->released.load(std::memory_order_acquire) && buffer->events.empty()) {
+                    buffer->released.store(false, std::memory_order_relaxed);
+                    buffer->name.store(nullptr, std::memory_order_relaxed);
+                    buffer->named = false;
+                    handle.buffer = buffer.get();
+                    break;
+                }
+            }
+            if (!handle.buffer) {
+                buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+                buffers.back()->tid = static_cast<int>(buffers.size());
+                handle.buffer = buffers.back().get();
+            }
+        }
+        return handle.buffer;
+    }
+
+    void flushLoop() {
+        while (active.load(std::memory_order_acquire) && SDL_GetPerformanceCounter() < deadline) {
+            flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        active.store(false, std::memory_order_release);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // let spans already open finish
+        flush();
+        std::fputs("\n]}\n", file);
+        fclose(file);
+        file = nullptr;
+        std::cout << "Trace written to " << tracePath << " (" << written << " events, " << dropped.load() << " dropped)" << std::endl;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        double usPerTick = 1e6 / SDL_GetPerformanceFrequency();
+        for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+            const char* name = buffer->name.load(std::memory_order_acquire);
+            if (name && !buffer->named) {
+                separate();
+                std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                             buffer->tid, name);
+                buffer->named = true;
+            }
+            TraceEvent event;
+            while (buffer->events.pop(event)) {
+                separate();
+                std::fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                             "\"args\":{\"scene\":%d,\"chapter\":%d}}",
+                             event.name, event.category, (event.start - origin) * usPerTick, (event.end - event.start) * usPerTick,
+                             buffer->tid, event.sceneID, event.chapterID);
+                ++written;
+            }
+        }
+        std::fflush(file);
+    }
+
+    void separate() {
+        if (!firstEvent) {
+            std::fputs(",\n", file);
+        }
+        firstEvent = false;
+    }
+};
+
+inline TraceRecorder& tracer() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+// Records the enclosing scope as a span while tracing is on; otherwise costs one atomic load.
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category, int sceneID = -1, int chapterID = -1) {
+        if (!tracer().isActive()) {
+            return;
+        }
+        event.name = name;
+        event.category = category;
+        event.sceneID = sceneID != -1 ? sceneID : tracer().contextScene();
+        event.chapterID = chapterID != -1 ? chapterID : tracer().contextChapter();
+        event.start = SDL_GetPerformanceCounter();
+        recording = true;
+    }
+
+    ~TraceScope() {
+        if (recording) {
+            event.end = SDL_GetPerformanceCounter();
+            tracer().record(event);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceEvent event;
+    bool recording = false;
+};
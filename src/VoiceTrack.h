@@ -0,0 +1,214 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <future>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "AudioCache.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "StreamMixer.h"
+#include "Trace.h"
+
+// The start of a voice clip, cooked and read ahead so it can begin without touching the disk.
+struct VoicePrefix {
+    std::string cookedPath; // empty if the clip is missing or could not be cooked
+    std::vector<Uint8> head;
+    std::string error;
+};
+
+// Voiced dialogue, one clip per scene. Clips are cooked to device-format PCM and streamed from
+// disk on a post-mix stage run by the AudioMonitor, so they play over the theme and effects.
+// When a scene starts, the clips of the scenes its choices lead to are cooked as jobs
+// and their first few hundred milliseconds read into memory; only those candidates are kept, so
+// memory does not grow with the story. A clip that is not ready yet starts late rather than
+// blocking the frame.
+class VoiceTrack {
+public:
+    static const int DefaultPrefetchMs = 300;
+    static const int CancelFadeMs = 40; // short enough to feel immediate, long enough not to click
+
+    void init(AudioCache& audioCache, int deviceBufferFrames, int prefetchMs = DefaultPrefetchMs) {
+        cache = &audioCache;
+        enabled = audioCache.isEnabled();
+        if (!enabled) {
+            return;
+        }
+        mixer.init(audioCache, deviceBufferFrames, StreamMixer::Stage::PostMix);
+        Sint64 bytes = static_cast<Sint64>(prefetchMs) * audioCache.getFrequency() / 1000 * audioCache.frameBytes();
+        prefixBytes = static_cast<size_t>(std::max<Sint64>(bytes, audioCache.frameBytes()));
+        ringBytes = static_cast<size_t>(audioCache.getFrequency()) * audioCache.frameBytes(); // one second
+    }
+
+    // Replaces the prefetch set with these clips. Clips outside the set are dropped.
+    void prefetch(const std::vector<std::string>& clipPaths) {
+        if (!enabled) {
+            return;
+        }
+        for (auto it = clips.begin(); it != clips.end();) {
+            bool keep = it->first == pendingClip || std::find(clipPaths.begin(), clipPaths.end(), it->first) != clipPaths.end();
+            if (keep) {
+                ++it;
+                continue;
+            }
+            if (it->second.loading.valid()) {
+                draining.push_back(std::move(it->second.loading)); // a worker is still on it
+            }
+            it = clips.erase(it);
+        }
+        for (const std::string& path : clipPaths) {
+            request(path);
+        }
+    }
+
+    // Plays a clip, cutting off the previous one. If its prefix is not ready it starts once it is.
+    void play(const std::string& clipPath) {
+        cancel();
+        if (!enabled || clipPath.empty()) {
+            return;
+        }
+        request(clipPath);
+        pendingClip = clipPath;
+        startPendingClip();
+    }
+
+    // Fades out the current clip and forgets one still waiting to start.
+    void cancel() {
+        pendingClip.clear();
+        mixer.fadeOut(CancelFadeMs);
+    }
+
+    // Collects finished prefetches and starts a clip that was waiting on one. Main thread, once per frame.
+    void update() {
+        mixer.update();
+        for (auto& entry : clips) {
+            Clip& clip = entry.second;
+            if (clip.loading.valid() && clip.loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                clip.prefix = clip.loading.get();
+                clip.ready = true;
+                if (!clip.prefix.error.empty()) {
+                    logError() << "Failed to prepare voice clip " << entry.first << ": " << clip.prefix.error;
+                }
+            }
+        }
+        draining.erase(std::remove_if(draining.begin(), draining.end(),
+                                      [](std::future<VoicePrefix>& load) {
+                                          return load.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                      }),
+                       draining.end());
+        startPendingClip();
+    }
+
+    bool isSpeaking() const { return !pendingClip.empty() || (mixer.isPlaying() && !mixer.isFadingOut()); }
+
+    size_t prefetchedBytes() const {
+        size_t total = 0;
+        for (const auto& entry : clips) {
+            total += entry.second.prefix.head.capacity();
+        }
+        return total;
+    }
+
+    const StreamMixer::Stats& getStats() const { return mixer.getStats(); }
+
+    // The post-mix stage the AudioMonitor runs, or nullptr when voice-over is disabled.
+    StreamMixer* getMixer() { return enabled ? &mixer : nullptr; }
+
+    // Call once the post-mix stage is no longer being run.
+    void shutdown() {
+        pendingClip.clear();
+        mixer.uninstall();
+        for (auto& entry : clips) {
+            if (entry.second.loading.valid()) {
+                entry.second.loading.wait();
+            }
+        }
+        clips.clear();
+        for (std::future<VoicePrefix>& load : draining) {
+            load.wait();
+        }
+        draining.clear();
+    }
+
+private:
+    struct Clip {
+        std::future<VoicePrefix> loading;
+        VoicePrefix prefix;
+        bool ready = false;
+    };
+
+    AudioCache* cache = nullptr;
+    bool enabled = false;
+    size_t prefixBytes = 0;
+    size_t ringBytes = 0;
+    StreamMixer mixer;
+    std::unordered_map<std::string, Clip> clips; // prefetch candidates plus the clip waiting to start
+    std::vector<std::future<VoicePrefix>> draining; // dropped while a worker was still cooking
+    std::string pendingClip;
+
+    void request(const std::string& path) {
+        if (path.empty() || clips.count(path)) {
+            return;
+        }
+        const AudioCache* audioCache = cache;
+        size_t bytes = prefixBytes;
+        clips[path].loading = jobs().async([audioCache, path, bytes]() { return loadPrefix(*audioCache, path, bytes); });
+    }
+
+    void startPendingClip() {
+        if (pendingClip.empty()) {
+            return;
+        }
+        auto it = clips.find(pendingClip);
+        if (it == clips.end() || !it->second.ready) {
+            return;
+        }
+        const VoicePrefix& prefix = it->second.prefix;
+        if (!prefix.cookedPath.empty()) {
+            PcmStream* stream = new PcmStream();
+            if (stream->open(*cache, prefix.cookedPath, false, ringBytes, &prefix.head)) {
+                mixer.play(stream, 0);
+            } else {
+                logError() << "Failed to stream voice clip " << prefix.cookedPath;
+                delete stream;
+            }
+        }
+        pendingClip.clear();
+    }
+
+    // Job: cooks the clip if needed and reads the start of its PCM.
+    static VoicePrefix loadPrefix(const AudioCache& audioCache, const std::string& path, size_t bytes) {
+        TraceScope trace("voice prefetch", "audio");
+        VoicePrefix prefix;
+        if (access(path.c_str(), R_OK) != 0) {
+            return prefix; // an unvoiced line
+        }
+        prefix.cookedPath = audioCache.cook(path, prefix.error);
+        if (prefix.cookedPath.empty()) {
+            return prefix;
+        }
+        CookedAudioHeader header;
+        int fd = open(prefix.cookedPath.c_str(), O_RDONLY);
+        if (fd < 0 || !audioCache.readHeader(prefix.cookedPath, header)) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            prefix.cookedPath.clear();
+            prefix.error = "cannot open cooked clip";
+            return prefix;
+        }
+        size_t frameBytes = static_cast<size_t>(audioCache.frameBytes());
+        size_t wanted = static_cast<size_t>(std::min<Uint64>(bytes, header.dataBytes));
+        prefix.head.resize(wanted - wanted % frameBytes);
+        ssize_t got = pread(fd, prefix.head.data(), prefix.head.size(), sizeof(CookedAudioHeader));
+        close(fd);
+        prefix.head.resize(got > 0 ? static_cast<size_t>(got) - static_cast<size_t>(got) % frameBytes : 0);
+        return prefix;
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Runs a batch of independent tasks on the job system. Each task returns a continuation (GPU
+// upload, cache insertion, ...) that is queued for the thread that started the batch, which
+// picks it up with pump() between frames.
+class WarmupBatch {
+public:
+    typedef std::function<void()> Continuation;
+    typedef std::function<Continuation()> Task;
+
+    ~WarmupBatch() {
+        cancel();
+        finish();
+    }
+
+    void run(std::vector<Task> batch, JobPriority priority = JobPriority::Normal) {
+        finish();
+        token.reset();
+        running = !batch.empty();
+        for (Task& task : batch) {
+            jobs().submit([this, task]() { continuations.post(task()); }, priority, &group, &token);
+        }
+    }
+
+    // Runs the continuations of every task finished so far. On the thread that started the batch.
+    void pump() { continuations.pump(); }
+
+    // Tasks that have not started are skipped; finish() still has to be called.
+    void cancel() { token.cancel(); }
+
+    // Waits for every task, then runs the remaining continuations.
+    void finish() {
+        jobs().wait(group);
+        pump();
+        running = false;
+    }
+
+    bool isDone() const { return group.isDone(); }
+    bool isRunning() const { return running; }
+
+private:
+    JobGroup group;
+    CancellationToken token;
+    ContinuationQueue continuations;
+    bool running = false;
+};
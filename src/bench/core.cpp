@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../core/Story.h"
+#include "../core/StoryNavigator.h"
+
+// Headless benchmark of the story engine alone: no SDL, no window, no assets. Walks the real
+// chapters with pseudo-random choices, going back to the menu and on to the next chapter at each
+// ending, and reports scene transitions per second. Fails if the rate is under --min-rate.
+
+struct CoreBenchOptions {
+    long long transitions = 20000000;
+    double minRate = 1000000.0; // transitions per second
+};
+
+static CoreBenchOptions parseCoreBenchOptions(int argc, char* argv[]) {
+    CoreBenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--transitions") == 0 && i + 1 < argc) {
+            options.transitions = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--min-rate") == 0 && i + 1 < argc) {
+            options.minRate = std::atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+        }
+    }
+    return options;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    CoreBenchOptions options = parseCoreBenchOptions(argc, argv);
+
+    std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+    Story story;
+    story.setChapters(buildChapters());
+    double loadMs = secondsSince(loadStart) * 1000.0;
+    if (story.chapterCount() == 0) {
+        fprintf(stderr, "The story has no chapters\n");
+        return 2;
+    }
+
+    StoryNavigator navigator;
+    navigator.reset(story);
+    navigator.selectChapter(0);
+    std::uint32_t random = 0x9E3779B9u; // xorshift32, fixed seed so runs are comparable
+    long long endings = 0;
+    long long checksum = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < options.transitions; ++i) {
+        if (navigator.atEnding()) {
+            navigator.returnToMenu();
+            navigator.selectChapter(static_cast<int>(++endings % story.chapterCount()));
+        } else {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            int choices = navigator.graph().choiceCount(navigator.getSceneID());
+            if (!choices || !navigator.choose(static_cast<int>(random % choices))) {
+                navigator.returnToMenu(); // dead end: treat it like an ending
+                navigator.selectChapter(static_cast<int>(++endings % story.chapterCount()));
+            }
+        }
+        checksum += navigator.getSceneID();
+    }
+    double seconds = secondsSince(start);
+
+    // What the game does on every scene change besides moving: rank the scenes by distance.
+    start = std::chrono::steady_clock::now();
+    long long queries = 0;
+    for (int c = 0; c < story.chapterCount(); ++c) {
+        for (int s = 0; s < story.graph(c).sceneCount(); ++s) {
+            checksum += story.graph(c).distancesFrom(s)[0];
+            ++queries;
+        }
+    }
+    double distanceUs = queries ? secondsSince(start) * 1e6 / queries : 0.0;
+
+    double rate = seconds > 0 ? options.transitions / seconds : 0.0;
+    std::cout << "Story loaded in " << loadMs << " ms (" << story.chapterCount() << " chapters)" << std::endl;
+    std::cout << options.transitions << " transitions in " << seconds * 1000.0 << " ms: " << rate / 1e6 << " million/s ("
+              << (rate > 0 ? 1e9 / rate : 0.0) << " ns each), " << endings << " endings, checksum " << checksum << std::endl;
+    std::cout << "Scene distances: " << distanceUs << " us per query over " << queries << " scenes" << std::endl;
+    if (rate < options.minRate) {
+        std::cout << "FAIL       under " << options.minRate / 1e6 << " million transitions/s" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#include "../AllocationHooks.h"
+#include "../Game.h"
+#include "../Log.h"
+
+// Headless benchmark: plays every scene of every chapter with the dummy video driver and the
+// software renderer, and writes per-scene load time, frame time, memory and allocations as JSON.
+// With --baseline it compares the totals against an earlier run and fails on regressions; with
+// --assert-zero-alloc it fails if any scene still allocates once it has settled. With --replay it
+// plays a recorded input log through the real game loop instead of walking the scenes. With
+// --decode-scaling it only decodes every scene image as one batch of jobs, on 1, 2, 4 ... threads.
+// With --sfx-stress it fires sound effects for that many seconds and fails if a trigger allocates.
+
+static const int SettleFrames = 3; // frames after the load before a scene counts as idle
+
+struct BenchOptions {
+    std::string outPath = "pamplemousse-bench.json";
+    std::string baselinePath;
+    double thresholdPercent = 10.0;
+    int frames = 30; // frames rendered per scene after the load
+    bool assertZeroAlloc = false;
+    std::string replayPath; // input log from --record-input
+    bool decodeScaling = false;
+    int maxThreads = 0;     // for --decode-scaling, 0 goes up to one per core
+    int sfxStressSeconds = 0;
+};
+
+struct SceneResult {
+    int chapter;
+    int scene;
+    double loadMs;
+    double frameMs;
+    double frameP99Ms;
+    long rssKB;
+    Uint64 loadAllocations;
+    Uint64 frameAllocations; // per frame, once settled
+    AllocationSnapshot idleAllocations; // everything allocated while settled, by subsystem
+};
+
+struct Totals {
+    int scenes = 0;
+    double loadMs = 0.0;
+    double frameMs = 0.0;
+    double frameP99Ms = 0.0;
+    long peakRssKB = 0;
+    Uint64 allocations = 0;
+};
+
+static long currentRssKB() {
+#ifdef __APPLE__
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return static_cast<long>(info.resident_size / 1024);
+#else
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    long pages = 0;
+    long resident = 0;
+    int read = fscanf(statm, "%ld %ld", &pages, &resident);
+    fclose(statm);
+    return read == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+#endif
+}
+
+static long peakRssKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss; // KiB on Linux
+#endif
+}
+
+// Scenes of a chapter in breadth-first order along the choice graph, leaving out the final empty
+// scene (rendering it returns to the menu).
+static std::vector<int> reachableScenes(const Chapter& chapter) {
+    std::vector<int> order;
+    int last = static_cast<int>(chapter.scenes.size()) - 1;
+    std::vector<bool> seen(chapter.scenes.size(), false);
+    std::deque<int> queue;
+    if (last > 0) {
+        queue.push_back(0);
+        seen[0] = true;
+    }
+    while (!queue.empty()) {
+        int sceneID = queue.front();
+        queue.pop_front();
+        order.push_back(sceneID);
+        for (const Choice& choice : chapter.scenes[sceneID].choices) {
+            int next = choice.nextSceneID;
+            if (next >= 0 && next < last && !seen[next]) {
+                seen[next] = true;
+                queue.push_back(next);
+            }
+        }
+    }
+    return order;
+}
+
+static std::vector<SceneResult> runScenes(Game& game, int frames) {
+    std::vector<SceneResult> results;
+    for (int c = 0; c < game.getChapterCount(); ++c) {
+        game.startChapter(c);
+        for (int sceneID : reachableScenes(game.getChapter(c))) {
+            SceneResult result;
+            result.chapter = c;
+            result.scene = sceneID;
+
+            AllocationSnapshot before = allocations().snapshot();
+            Uint64 start = SDL_GetPerformanceCounter();
+            game.goToScene(sceneID);
+            game.render(); // first frame pays for the image and text layout
+            result.loadMs = ticksToMs(SDL_GetPerformanceCounter() - start);
+            result.loadAllocations = (allocations().snapshot() - before).totalCount();
+
+            RollingStat frameTimes;
+            for (int f = 0; f < SettleFrames + frames; ++f) {
+                if (f == SettleFrames) {
+                    before = allocations().snapshot();
+                }
+                Uint64 frameStart = SDL_GetPerformanceCounter();
+                game.render();
+                frameTimes.add(ticksToMs(SDL_GetPerformanceCounter() - frameStart));
+                game.updateAudio();
+            }
+            result.idleAllocations = allocations().snapshot() - before;
+            result.frameMs = frameTimes.average();
+            result.frameP99Ms = frameTimes.percentile(0.99);
+            result.frameAllocations = frames > 0 ? result.idleAllocations.totalCount() / frames : 0;
+            result.rssKB = currentRssKB();
+            results.push_back(result);
+        }
+    }
+    return results;
+}
+
+static Totals summarize(const std::vector<SceneResult>& results) {
+    Totals totals;
+    for (const SceneResult& result : results) {
+        ++totals.scenes;
+        totals.loadMs += result.loadMs;
+        totals.frameMs += result.frameMs;
+        totals.frameP99Ms = std::max(totals.frameP99Ms, result.frameP99Ms);
+        totals.allocations += result.loadAllocations;
+    }
+    if (totals.scenes) {
+        totals.frameMs /= totals.scenes;
+    }
+    totals.peakRssKB = peakRssKB();
+    return totals;
+}
+
+static const char* TotalsParseFormat = "{\"scenes\":%d,\"loadMs\":%lf,\"frameMs\":%lf,\"frameP99Ms\":%lf,\"peakRssKB\":%ld,\"allocations\":%llu}";
+
+// One scene per line, so runs diff cleanly and the baseline can be read back without a JSON parser.
+static bool writeReport(const std::string& path, const std::vector<SceneResult>& results, const Totals& totals) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    fprintf(out, "{\n  \"version\": 1,\n  \"totals\": ");
+    fprintf(out, "{\"scenes\":%d,\"loadMs\":%.3f,\"frameMs\":%.3f,\"frameP99Ms\":%.3f,\"peakRssKB\":%ld,\"allocations\":%llu}",
+            totals.scenes, totals.loadMs, totals.frameMs, totals.frameP99Ms, totals.peakRssKB, static_cast<unsigned long long>(totals.allocations));
+    fprintf(out, ",\n  \"scenes\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SceneResult& r = results[i];
+        fprintf(out, "    {\"chapter\":%d,\"scene\":%d,\"loadMs\":%.3f,\"frameMs\":%.3f,\"frameP99Ms\":%.3f,\"rssKB\":%ld,"
+                     "\"loadAllocations\":%llu,\"frameAllocations\":%llu}%s\n",
+                r.chapter, r.scene, r.loadMs, r.frameMs, r.frameP99Ms, r.rssKB, static_cast<unsigned long long>(r.loadAllocations),
+                static_cast<unsigned long long>(r.frameAllocations), i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return fclose(out) == 0;
+}
+
+static bool readBaselineTotals(const std::string& path, Totals& totals) {
+    FILE* in = fopen(path.c_str(), "r");
+    if (!in) {
+        return false;
+    }
+    char line[512];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), in)) {
+        const char* start = std::strstr(line, "\"totals\": ");
+        unsigned long long allocations = 0;
+        found = start && sscanf(start + std::strlen("\"totals\": "), TotalsParseFormat, &totals.scenes, &totals.loadMs, &totals.frameMs,
+                                &totals.frameP99Ms, &totals.peakRssKB, &allocations) == 6;
+        totals.allocations = allocations;
+    }
+    fclose(in);
+    return found;
+}
+
+// Idle frames on a settled scene must not touch the heap; lists every scene that did.
+static bool checkZeroAllocations(const std::vector<SceneResult>& results) {
+    bool passed = true;
+    for (const SceneResult& result : results) {
+        if (result.idleAllocations.totalCount()) {
+            std::cout << "ALLOCATES  chapter " << result.chapter << " scene " << result.scene << ": "
+                      << result.idleAllocations.describe() << std::endl;
+            passed = false;
+        }
+    }
+    if (passed) {
+        std::cout << "ok         no allocations while idling on " << results.size() << " scenes" << std::endl;
+    }
+    return passed;
+}
+
+// A metric regresses when it grows by more than the threshold and by more than noise.
+static bool checkMetric(const char* name, double baseline, double current, double thresholdPercent, double noise) {
+    bool regressed = current > baseline * (1.0 + thresholdPercent / 100.0) && current - baseline > noise;
+    double change = baseline > 0 ? (current - baseline) * 100.0 / baseline : 0.0;
+    std::cout << (regressed ? "REGRESSION " : "ok         ") << name << ": " << baseline << " -> " << current << " ("
+              << (change >= 0 ? "+" : "") << change << "%)" << std::endl;
+    return !regressed;
+}
+
+static bool compareWithBaseline(const Totals& baseline, const Totals& current, double thresholdPercent) {
+    if (baseline.scenes != current.scenes) {
+        std::cout << "Scene count changed (" << baseline.scenes << " -> " << current.scenes << "); comparing totals anyway" << std::endl;
+    }
+    bool passed = true;
+    passed &= checkMetric("load ms", baseline.loadMs, current.loadMs, thresholdPercent, 1.0);
+    passed &= checkMetric("frame ms", baseline.frameMs, current.frameMs, thresholdPercent, 0.1);
+    passed &= checkMetric("frame p99 ms", baseline.frameP99Ms, current.frameP99Ms, thresholdPercent, 0.5);
+    passed &= checkMetric("peak RSS KiB", baseline.peakRssKB, current.peakRssKB, thresholdPercent, 1024);
+    passed &= checkMetric("load allocations", static_cast<double>(baseline.allocations), static_cast<double>(current.allocations),
+                          thresholdPercent, 0);
+    return passed;
+}
+
+// Runs the recorded session unpaced through Game::run and reports the whole run.
+static int runReplay(Game& game, const BenchOptions& benchOptions) {
+    AllocationSnapshot before = allocations().snapshot();
+    Uint64 start = SDL_GetPerformanceCounter();
+    game.run();
+    double wallMs = ticksToMs(SDL_GetPerformanceCounter() - start);
+    Uint64 allocated = (allocations().snapshot() - before).totalCount();
+    Uint64 frames = game.getFrameCount();
+    const RollingStat* frameTimes = game.getStats().find("frame");
+    double frameP99Ms = frameTimes ? frameTimes->percentile(0.99) : 0.0;
+    game.clean();
+
+    FILE* out = fopen(benchOptions.outPath.c_str(), "w");
+    if (!out) {
+        logError() << "Cannot write " << benchOptions.outPath;
+        return 2;
+    }
+    fprintf(out, "{\n  \"version\": 1,\n  \"replay\": {\"frames\":%llu,\"wallMs\":%.3f,\"frameMs\":%.3f,\"frameP99Ms\":%.3f,"
+                 "\"peakRssKB\":%ld,\"allocations\":%llu}\n}\n",
+            static_cast<unsigned long long>(frames), wallMs, frames ? wallMs / frames : 0.0, frameP99Ms, peakRssKB(),
+            static_cast<unsigned long long>(allocated));
+    if (fclose(out) != 0) {
+        return 2;
+    }
+    std::cout << "Replayed " << frames << " frames in " << wallMs << " ms -> " << benchOptions.outPath << std::endl;
+    return 0;
+}
+
+// Decodes every scene image on a fresh job system per thread count and reports the speed-up
+// over one thread. The disk cache stays off, so every run decodes from the source files.
+static int runDecodeScaling(const BenchOptions& benchOptions) {
+    if (!(IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) & IMG_INIT_PNG)) {
+        logError() << "SDL_image could not initialize! IMG_Error: " << IMG_GetError();
+        return 2;
+    }
+    Story story;
+    story.setChapters(buildChapters());
+    std::vector<std::string> paths;
+    for (const Chapter& chapter : story.getChapters()) {
+        for (const Scene& scene : chapter.scenes) {
+            if (!scene.imagePath.empty() && std::find(paths.begin(), paths.end(), scene.imagePath) == paths.end()) {
+                paths.push_back(scene.imagePath);
+            }
+        }
+    }
+    ImageDiskCache noCache;
+    unsigned maxThreads = benchOptions.maxThreads > 0 ? static_cast<unsigned>(benchOptions.maxThreads) : std::max(1u, std::thread::hardware_concurrency());
+    double oneThreadMs = 0.0;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        JobSystem system(threads);
+        JobGroup group;
+        std::atomic<int> decoded{0};
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (const std::string& path : paths) {
+            system.submit([&noCache, &decoded, path]() {
+                DecodedImage image;
+                if (loadDisplayImage(noCache, path, isJpegPath(path), 800, 600, image)) {
+                    ++decoded;
+                }
+            }, JobPriority::Normal, &group);
+        }
+        system.wait(group);
+        double ms = ticksToMs(SDL_GetPerformanceCounter() - start);
+        if (threads == 1) {
+            oneThreadMs = ms;
+        }
+        double speedup = ms > 0 ? oneThreadMs / ms : 0.0;
+        printf("%2u threads: %d/%zu images in %8.1f ms, %.2fx, %3.0f%% efficiency, %llu stolen\n", threads, decoded.load(), paths.size(), ms,
+               speedup, speedup * 100.0 / threads, static_cast<unsigned long long>(system.getStats().stolen.load()));
+        if (threads >= maxThreads) {
+            break;
+        }
+    }
+    IMG_Quit();
+    return 0;
+}
+
+static BenchOptions parseBenchOptions(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            options.outPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            options.baselinePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            options.thresholdPercent = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--assert-zero-alloc") == 0) {
+            options.assertZeroAlloc = true;
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--decode-scaling") == 0) {
+            options.decodeScaling = true;
+        } else if (std::strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc) {
+            options.maxThreads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sfx-stress") == 0 && i + 1 < argc) {
+            options.sfxStressSeconds = std::atoi(argv[++i]);
+        } else {
+            logWarning() << "Unknown option: " << argv[i];
+        }
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions benchOptions = parseBenchOptions(argc, argv);
+    if (benchOptions.decodeScaling) {
+        return runDecodeScaling(benchOptions);
+    }
+
+    // No display, GPU or sound card: SDL_VIDEODRIVER=offscreen still wins if set.
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+    setenv("SDL_AUDIODRIVER", "dummy", 0);
+
+    // Before SDL_Init, so surfaces and textures are counted too.
+    allocations().installSdlHooks();
+
+    GameOptions options;
+    options.softwareRenderer = true;
+    options.imageCacheMB = 0; // every run decodes, so load times do not depend on the cache state
+    options.audioBufferFrames = AudioMonitor::DefaultBufferFrames;
+    options.replayInputPath = benchOptions.replayPath;
+    options.replayFast = true;
+    options.replayThenQuit = true;
+    options.renderThread = false; // frames are drawn and timed where they are submitted
+    options.saveGames = false;    // runs start at the menu and leave the player's saves alone
+    options.resumeSlot = -1;
+    options.sfxStressSeconds = benchOptions.sfxStressSeconds;
+    Game game(options);
+    if (!game.init("Pamplemousse bench", 800, 600)) {
+        return 2;
+    }
+    if (benchOptions.sfxStressSeconds > 0) {
+        int status = game.runSoundEffectStress();
+        game.clean();
+        return status;
+    }
+    if (!benchOptions.replayPath.empty()) {
+        return runReplay(game, benchOptions);
+    }
+
+    std::vector<SceneResult> results = runScenes(game, benchOptions.frames);
+    Totals totals = summarize(results);
+    game.clean();
+
+    if (!writeReport(benchOptions.outPath, results, totals)) {
+        logError() << "Cannot write " << benchOptions.outPath;
+        return 2;
+    }
+    std::cout << totals.scenes << " scenes: " << totals.loadMs << " ms loading, " << totals.frameMs << " ms per frame, "
+              << totals.peakRssKB << " KiB peak RSS, " << totals.allocations << " allocations while loading -> " << benchOptions.outPath
+              << std::endl;
+
+    bool passed = !benchOptions.assertZeroAlloc || checkZeroAllocations(results);
+    if (!benchOptions.baselinePath.empty()) {
+        Totals baseline;
+        if (!readBaselineTotals(benchOptions.baselinePath, baseline)) {
+            logError() << "Cannot read baseline " << benchOptions.baselinePath;
+            return 2;
+        }
+        passed &= compareWithBaseline(baseline, totals, benchOptions.thresholdPercent);
+    }
+    return passed ? 0 : 1;
+}
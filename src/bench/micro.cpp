@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "../Game.h"
+#include "../Log.h"
+
+// Micro-benchmarks for the engine's hot functions in isolation: text wrapping, image fitting,
+// building the story and switching chapters. Real inputs come from the story itself; synthetic
+// ones scale text length and scene count so the complexity shows, not just the constants.
+
+static const int DialogueLineWidth = 680; // scene text box width less its padding
+
+static TTF_Font* font = nullptr;
+
+// Synthetic text built from the story's own vocabulary, so glyph widths stay realistic.
+static std::string syntheticText(int words) {
+    static const char* vocabulary[] = {"Juliette", "regarde", "la", "mer", "depuis", "la", "terrasse,", "un", "café",
+                                       "à", "la", "main,", "et", "se", "demande", "qui", "est", "la", "taupe."};
+    const int vocabularySize = sizeof(vocabulary) / sizeof(vocabulary[0]);
+    std::string text;
+    for (int i = 0; i < words; ++i) {
+        text += (i ? " " : "");
+        text += vocabulary[i % vocabularySize];
+    }
+    return text;
+}
+
+static Chapter syntheticChapter(int sceneCount) {
+    Chapter chapter;
+    chapter.title = "Synthetic";
+    chapter.themeMusicPath = "../audio/synthetic_theme.mp3";
+    for (int i = 0; i < sceneCount; ++i) {
+        int next = std::min(i + 1, sceneCount - 1);
+        chapter.scenes.push_back({i, syntheticText(20), {{"Suite ...", next}, {"Retour", 0}}, {0, 0, 0, 255},
+                                  "../images/Synthetic/scene_" + std::to_string(i % 16) + ".jpg"});
+    }
+    assignVoiceClips(chapter);
+    return chapter;
+}
+
+static void BM_WrapText(benchmark::State& state, std::string text) {
+    for (auto _ : state) {
+        TextLayout layout = wrapText(font, text, DialogueLineWidth);
+        benchmark::DoNotOptimize(layout.lines.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * text.size());
+}
+
+static void BM_WrapSynthetic(benchmark::State& state) {
+    std::string text = syntheticText(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        TextLayout layout = wrapText(font, text, DialogueLineWidth);
+        benchmark::DoNotOptimize(layout.lines.data());
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+// Landscape, portrait and square sources into the 800x600 window.
+static void BM_FitRect(benchmark::State& state) {
+    static const int sizes[][2] = {{1920, 1080}, {1080, 1920}, {1024, 1024}, {4032, 3024}, {640, 480}};
+    int i = 0;
+    for (auto _ : state) {
+        SDL_Rect rect = fitRect(sizes[i][0], sizes[i][1], 800, 600);
+        benchmark::DoNotOptimize(rect);
+        i = (i + 1) % 5;
+    }
+}
+BENCHMARK(BM_FitRect);
+
+static void BM_LoadChapters(benchmark::State& state) {
+    Game game;
+    for (auto _ : state) {
+        game.loadChapters();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_LoadChapters)->Unit(benchmark::kMicrosecond);
+
+// What picking a chapter costs now that the game points into the story instead of copying it.
+static void BM_SwitchChapter(benchmark::State& state) {
+    Game game;
+    game.loadChapters();
+    StoryNavigator navigator;
+    navigator.reset(game.getStory());
+    int chapterID = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        navigator.selectChapter(chapterID);
+        benchmark::DoNotOptimize(navigator.getSceneID());
+    }
+    const Chapter& chapter = game.getChapter(chapterID);
+    state.SetLabel(chapter.title + ", " + std::to_string(chapter.scenes.size()) + " scenes");
+}
+BENCHMARK(BM_SwitchChapter)->DenseRange(0, 1);
+
+// Building a chapter's choice graph, which happens once per chapter at load.
+static void BM_BuildStorySynthetic(benchmark::State& state) {
+    std::vector<Chapter> chapters(1, syntheticChapter(static_cast<int>(state.range(0))));
+    Story story;
+    for (auto _ : state) {
+        story.setChapters(chapters);
+        benchmark::DoNotOptimize(&story.graph(0));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_BuildStorySynthetic)->RangeMultiplier(4)->Range(16, 16384)->Complexity()->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char* argv[]) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    // Wrapping needs the real font; the rest runs without it.
+    if (TTF_Init() == -1 || !(font = TTF_OpenFont("../fonts/Avenir.ttc", 24))) {
+        logWarning() << "Failed to load font, skipping the wrap benchmarks. TTF_Error: " << TTF_GetError();
+    } else {
+        Game game;
+        game.loadChapters();
+        for (int c = 0; c < game.getChapterCount(); ++c) {
+            const Chapter& chapter = game.getChapter(c);
+            for (const Scene& scene : chapter.scenes) {
+                if (scene.dialogue.empty()) {
+                    continue;
+                }
+                std::string name = "BM_WrapText/" + chapter.title + "/" + std::to_string(scene.id);
+                benchmark::RegisterBenchmark(name.c_str(), BM_WrapText, sceneText(scene));
+            }
+        }
+        benchmark::RegisterBenchmark("BM_WrapSynthetic", BM_WrapSynthetic)->RangeMultiplier(4)->Range(4, 4096)->Complexity();
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    if (font) {
+        TTF_CloseFont(font);
+    }
+    TTF_Quit();
+    return 0;
+}
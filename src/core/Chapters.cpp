@@ -0,0 +1,135 @@
+#include "Story.h"
+
+std::vector<Chapter> buildChapters() {
+    std::vector<Chapter> chapters;
+    Chapter poulpe;
+    poulpe.title = "Poulpe";
+    poulpe.scenes.push_back({0, "La vie parisienne enveloppe Juliette, jeune étudiante en école de mode, dans son petit appartement sous les toits.", {{"Suite ...", 1}}, {0, 0, 0, 255}, "../images/Poulpe/ballade_paris_0.png"});
+    poulpe.scenes.push_back({1, "Aujourd'hui, la solitude lui pèse, et l’air de Paris semble l’appeler.", {{"Suite ...", 2}}, {0, 0, 0, 255}, "../images/Poulpe/ballade_paris_0.png"});
+    poulpe.scenes.push_back({2, "Elle enfile son manteau et descend les escaliers grinçants, décidée à se perdre dans les rues.", {{"Suite ...", 3}}, {0, 0, 0, 255}, "../images/Poulpe/ballade_paris_0.png"});
+    poulpe.scenes.push_back({3, "Elle croise son reflet dans une vitrine. Ses cheveux tombent comme un rideau fatigué autour de son visage.", {{"Suite ...", 4}}, {0, 0, 0, 255}, "../images/Poulpe/coiffure.png"});
+    poulpe.scenes.push_back({4, "Pourquoi pas un changement ?, pensa-t-elle.", {{"Ça me remettra les idées en place.", 7}, {"Je n'ai pas l'énergie.", 5}}, {0, 0, 0, 255}, "../images/Poulpe/coiffure.png"});
+    poulpe.scenes.push_back({5, "Vraiment pas ? Tu es sûre ?", {{"Bon d'accord.", 7}, {"NON.", 6}}, {0, 0, 0, 255}, "../images/Poulpe/coiffure_1.png"});
+    poulpe.scenes.push_back({6, "NON ??? Comment ça non ? Il FAUT changer ça tout de suite!", {{"Bon d'accord.", 7}}, {0, 0, 0, 255}, "../images/Poulpe/coiffure_2.png"});
+    poulpe.scenes.push_back({7, "Chez la coiffeuse, Juliette ose une nouvelle frange. En sortant, une brise caresse son visage, et elle se sent légère, comme si quelque chose avait changé en elle.", {{"Suite ...", 8}}, {0, 0, 0, 255}, "../images/Poulpe/ballade_paris_1.png"});
+    poulpe.scenes.push_back({8, "Une fresque attire son regard : un poulpe majestueux peint sur un vieux mur décrépit. Ses tentacules semblent l’appeler, et une étrange sensation naît en elle.", {{"Suite ...", 9}}, {0, 0, 0, 255}, "../images/Poulpe/rencontre.png"});
+    poulpe.scenes.push_back({9, "Pourquoi cette peinture la touche-t-elle autant ? Il faut que je le retrouve… murmure-t-elle.", {{"Suite ...", 10}}, {0, 0, 0, 255}, "../images/Poulpe/rencontre.png"});
+    poulpe.scenes.push_back({10, "Mais demain, elle part à l’île de Ré. Les billets de train sont déjà prêts.", {{"Continuer vers le poulpe ?", 11}, {"Aller se reposer avant le voyage ?", 14}}, {0, 0, 0, 255}, "../images/Poulpe/rencontre.png"});
+    poulpe.scenes.push_back({11, "En suivant la direction du poulpe, elle rencontre Mathis, un garçon au sourire franc.", {{"Suite ...", 12}}, {0, 0, 0, 255}, "../images/Poulpe/mathis_0.png"});
+    poulpe.scenes.push_back({12, "Ils parlent, rient, cherchent le poulpe ensemble, mais sans succès.", {{"Suite ...", 13}}, {0, 0, 0, 255}, "../images/Poulpe/mathis_0.png"});
+    poulpe.scenes.push_back({13, "Viens avec moi à l’île de Ré, lui propose-t-elle, presque sur un coup de tête. Il accepte.", {{"Suite ...", 16}}, {0, 0, 0, 255}, "../images/Poulpe/mathis_0.png"});
+    poulpe.scenes.push_back({14, "Le lendemain, fatiguée du long voyage, elle arrive à l’île : Le vent salé de l’océan l’accueille, mais ses pas sont lourds.", {{"Suite ...", 15}}, {0, 0, 0, 255}, "../images/Poulpe/arrivee_ile.png"});
+    poulpe.scenes.push_back({15, "Elle s’endort rapidement, rêvant de poulpes et de mystères.", {{"Suite ...", 18}}, {0, 0, 0, 255}, "../images/Poulpe/arrivee_ile.png"});
+    poulpe.scenes.push_back({16, "Le lendemain, fatiguée du long voyage, ils arrivent à l’île : Le vent salé de l’océan les accueille, mais leurs pas sont lourds.", {{"Suite ...", 17}}, {0, 0, 0, 255}, "../images/Poulpe/arrivee_ile.png"});
+    poulpe.scenes.push_back({17, "Elle s’endort rapidement, rêvant de poulpes et de mystères. Avec une pensée pour Mathis qui dort dans la chambre d'à côté.", {{"Suite ...", 19}}, {0, 0, 0, 255}, "../images/Poulpe/arrivee_ile.png"});
+    poulpe.scenes.push_back({18, "Au matin, seule, Juliette construit un pont de sable. Malgré sa joie, son esprit est ailleurs.", {{"Suite ...", 20}}, {0, 0, 0, 255}, "../images/Poulpe/pont_juliette.png"});
+    poulpe.scenes.push_back({19, "Au matin, avec Mathis, ils bâtissent ensemble un pont de sable, leurs mains s’effleurant dans les grains dorés.", {{"Suite ...", 21}}, {0, 0, 0, 255}, "../images/Poulpe/pont_mathis.png"});
+    poulpe.scenes.push_back({20, "Elle enfourche un vélo et se perd dans les marais en quête du poulpe.", {{"Suite ...", 23}}, {0, 0, 0, 255}, "../images/Poulpe/velo.png"});
+    poulpe.scenes.push_back({21, "Avec Mathis, ils pédalent côte à côte, leurs rires se mêlant au vent marin.", {{"Suite ...", 22}}, {0, 0, 0, 255}, "../images/Poulpe/velo.png"});
+    poulpe.scenes.push_back({22, "Ils cherchent toujours ce poulpe, mais rien. Une certaine désillusion commence à apparaître.", {{"Suite ...", 25}}, {0, 0, 0, 255}, "../images/Poulpe/velo.png"});
+    poulpe.scenes.push_back({23, "Sous le sable, elle découvre un garçon enterré. Elle creuse pour le libérer. Il s'appelle Mathis et était en train de rêver d'un poulpe.", {{"Suite ...", 24}}, {0, 0, 0, 255}, "../images/Poulpe/mathis_enterre.png"});
+    poulpe.scenes.push_back({24, "Lorsqu'il se réveilla il était enterré. Bizarre...", {{"Suite ...", 26}}, {0, 0, 0, 255}, "../images/Poulpe/mathis_enterre.png"});
+    poulpe.scenes.push_back({25, "Elle enfouit Mathis sous le sable pour plaisanter, leurs éclats de rire résonnant dans l’air chaud.", {{"Suite ...", 26}}, {0, 0, 0, 255}, "../images/Poulpe/mathis_enterre.png"});
+    poulpe.scenes.push_back({26, "Mathis la regarde, ses yeux brillants d’une lueur tendre. Juliette sent son cœur battre plus fort.", {{"Suite ...", 27}}, {0, 0, 0, 255}, "../images/Poulpe/seduction.png"});
+    poulpe.scenes.push_back({27, "Dois-je l’embrasser ? hésite-t-elle.", {{"Oui !", 28}, {"C'est peut-être trop tôt.", 29}}, {0, 0, 0, 255}, "../images/Poulpe/seduction.png"});
+    poulpe.scenes.push_back({28, "Leur baiser est doux, infini, et le temps semble s’arrêter.", {{"Suite ...", 30}}, {0, 0, 0, 255}, "../images/Poulpe/bisou.png"});
+    poulpe.scenes.push_back({29, "Mathis s’approche ... Et si on s’embrassait ? proposa-t-il.", {{"Suite ...", 28}}, {0, 0, 0, 255}, "../images/Poulpe/seduction.png"});
+    poulpe.scenes.push_back({30, "De retour dans la ville lumière, ils arpentent les rues main dans la main, toujours à la recherche du poulpe.", {{"Suite ...", 31}}, {0, 0, 0, 255}, "../images/Poulpe/retour_paris.png"});
+    poulpe.scenes.push_back({31, "Et puis… là-bas, dans l’ombre, ils aperçoivent enfin une forme familière.", {{"Suite ...", 32}}, {0, 0, 0, 255}, "../images/Poulpe/retour_paris.png"});
+    poulpe.scenes.push_back({32, "Le poulpe est sauvé et trouve refuge dans le lit de Juliette. À ses côtés, Mathis s’installe, son bras passé autour d’elle. Leurs cœurs battent à l’unisson.", {{"Retour à l'écran d'accueil.", 33}}, {0, 0, 0, 255}, "../images/Poulpe/fin.png"});
+    poulpe.scenes.push_back({33, "", {}, {0, 0, 0, 255}, ""});
+    setAmbience(poulpe, 0, 13, SoundEffectID::AmbientCity);
+    setAmbience(poulpe, 14, 29, SoundEffectID::AmbientSea);
+    setAmbience(poulpe, 30, 32, SoundEffectID::AmbientCity);
+    assignVoiceClips(poulpe);
+    buildTextBoxes(poulpe);
+    poulpe.themeMusicPath = "../audio/poulpe_theme.mp3";
+    chapters.push_back(poulpe);
+
+
+    Chapter taupe;
+    taupe.title = "Taupe";
+    taupe.scenes.push_back({0, "Juliette est entourée de ses amis sur la terrasse. L'atmosphère est joyeuse, mais une tension sous-jacente flotte dans l'air. Une taupe est parmi eux.", {{"Suite ...", 1}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_0.jpg"});
+    taupe.scenes.push_back({1, "Léna : 'Une taupe, sérieusement ? C’est un peu extrême comme jeu, non ?'", {{"Suite ...", 2}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_0.jpg"});
+    taupe.scenes.push_back({2, "Mathis : 'Mais c’est ça qui est fun ! Tout le monde peut bluffer, mais personne ne doit être éliminé trop tôt…'", {{"Suite ...", 3}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_0.jpg"});
+    taupe.scenes.push_back({3, "Aurélien : 'C’est Juliette qui décidera. Si elle désigne un groupe sans la taupe, elle perd.'", {{"Suite ...", 4}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_0.jpg"});
+    taupe.scenes.push_back({4, "Juliette observe ses amis, un mélange d’excitation et de nervosité.", {{"Observer les réactions", 5}, {"Poser des questions générales", 7}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_0.jpg"});
+    taupe.scenes.push_back({5, "Juliette décide d’observer les réactions de ses amis. Romane rit nerveusement, Cyriel reste concentré sur son téléphone.'", {{"Suite ...", 6}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_1.jpg"});
+    taupe.scenes.push_back({6, "Waldemar plaisante en disant : 'Ça pourrait être moi, mais bon, je suis un piètre menteur.'", {{"Suite ...", 10}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_1.jpg"});
+    taupe.scenes.push_back({7, "Juliette pose une question ouverte : 'Si vous deviez choisir quelqu’un comme taupe, qui serait-ce ?'", {{"Suite ...", 8}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_1.jpg"});
+    taupe.scenes.push_back({8, "Les réactions varient : Romane : 'Je ne sais pas, peut-être quelqu’un de très discret ?'", {{"Suite ...", 9}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_1.jpg"});
+    taupe.scenes.push_back({9, "Cyriel reste silencieux, tandis que Waldemar sourit subtilement. Cela intrigue Juliette.", {{"Suite ...", 10}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_1.jpg"});
+    taupe.scenes.push_back({10, "Juliette doit choisir un groupe pour observer plus attentivement. Qui choisir ?", {{"Léna, Romane, Waldemar", 11}, {"Mathis, Cyriel, Timothée", 13}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_2.jpg"});
+    taupe.scenes.push_back({11, "Juliette observe Léna, Romane, et Waldemar. Léna mentionne un projet de design urgent, ...", {{"Suite ...", 12}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_2.jpg"});
+    taupe.scenes.push_back({12, "... Romane change de sujet en parlant de cuisine, et Waldemar consulte discrètement son téléphone. Cela semble étrange.", {{"Suite ...", 15}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_2.jpg"});
+    taupe.scenes.push_back({13, "Juliette observe Mathis, Cyriel, et Timothée. Mathis parle avec enthousiasme de leur prochaine sortie en vélo, ...", {{"Suite ...", 14}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_2.jpg"});
+    taupe.scenes.push_back({14, "... Timothée est plus silencieux que d’habitude, et Cyriel semble nerveux, jouant distraitement avec un objet.", {{"Suite ...", 15}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_2.jpg"});
+    taupe.scenes.push_back({15, "Juliette réfléchit aux indices qu’elle a collectés. Quelque chose semble hors de l’ordinaire, mais elle a besoin de plus d’informations pour avancer.", {{"Suite ...", 16}}, {0, 0, 0, 255}, "../images/Taupe/terrasse_3.jpeg"});
+    taupe.scenes.push_back({16, "Le lendemain matin, les amis se retrouvent pour un petit-déjeuner sur la terrasse. L'atmosphère est plus détendue, mais Juliette garde un œil attentif sur chacun.", {{"Suite ...", 17}}, {0, 0, 0, 255}, "../images/Taupe/petit_dej_0.jpg"});
+    taupe.scenes.push_back({17, "Bénédicte : 'Ce jeu me stresse un peu. Je préfère rester dans les coulisses, mais je peux t’aider si tu veux.'", {{"Suite ...", 18}}, {0, 0, 0, 255}, "../images/Taupe/petit_dej_bene.jpeg"});
+    taupe.scenes.push_back({18, "Son offre semble sincère, mais Juliette hésite.", {{"Accepter l’aide de Bénédicte", 19}, {"Refuser poliment", 20}}, {0, 0, 0, 255}, "../images/Taupe/petit_dej_bene.jpeg"});
+    taupe.scenes.push_back({19, "Bénédicte : 'Bon, on va observer les autres ensemble.' Elle note que Waldemar semble préoccupé et que Timothée évite les regards directs. Cela intrigue Juliette.", {{"Suite ...", 21}}, {0, 0, 0, 255}, "../images/Taupe/petit_dej_bene.jpeg"});
+    taupe.scenes.push_back({20, "Juliette : 'Merci, mais je préfère faire ça seule.' Elle observe discrètement, remarquant que Cyriel évite toujours de se mêler à la conversation.", {{"Suite ...", 21}}, {0, 0, 0, 255}, "../images/Taupe/petit_dej_mathis.jpg"});
+    taupe.scenes.push_back({21, "Les amis décident de se diviser pour des activités. Juliette choisit une activité pour se rapprocher de certains amis.", {{"Aller à la plage des massages", 22}, {"Participer à un jeu de société", 23}}, {0, 0, 0, 255}, "../images/Taupe/petit_dej_1.jpg"});
+    taupe.scenes.push_back({22, "À la plage des massages, Mathis et Waldemar discutent calmement. Waldemar évoque un projet d’architecture, mais il semble distrait. Juliette note son comportement.", {{"Suite ...", 24}}, {0, 0, 0, 255}, "../images/Taupe/plage_massages.jpg"});
+    taupe.scenes.push_back({23, "Lors du jeu de société, Cyriel et Timothée jouent en duo. Cyriel se montre inhabituellement compétitif, mais Timothée reste en retrait.", {{"Suite ...", 24}}, {0, 0, 0, 255}, "../images/Taupe/jeu_societe.jpg"});
+    taupe.scenes.push_back({24, "Juliette rassemble ses pensées. Les comportements de Waldemar, Cyriel et Timothée restent suspects. Elle sait que son prochain choix sera crucial.", {{"Suite ...", 25}}, {0, 0, 0, 255}, "../images/Taupe/recap_jour_2.jpg"});
+    taupe.scenes.push_back({25, "Juliette décide de commencer la journée en explorant la vieille ville avec ses amis. L’ambiance est détendue, mais elle garde l'œil ouvert pour des indices.", {{"Suite ...", 26}}, {0, 0, 0, 255}, "../images/Taupe/vieille_ville_pano.jpg"});
+    taupe.scenes.push_back({26, "Léna : 'Tu as une idée de qui pourrait être la taupe ?' Aurélien : 'Ce jeu est une excellente métaphore politique. La suspicion et les alliances se forment naturellement.'", {{"Suite ...", 27}}, {0, 0, 0, 255}, "../images/Taupe/vieille_ville_ombre.jpeg"});
+    taupe.scenes.push_back({27, "Juliette trouve son analyse intéressante mais se concentre sur les comportements. Elle voit que Benoît n'est pas très joueur.", {{"Suite ...", 28}}, {0, 0, 0, 255}, "../images/Taupe/vieille_ville_ombre.jpeg"});
+    taupe.scenes.push_back({28, "Les amis se séparent à nouveau pour des activités. Juliette peut choisir où aller pour interagir avec d’autres groupes.", {{"Rejoindre Mathis et Bénédicte à la plage des massages", 29}, {"Aller chiller à la cuisine avec Romane et Timothée", 30}}, {0, 0, 0, 255}, "../images/Taupe/choix_activites.jpeg"});
+    taupe.scenes.push_back({29, "À la plage des massages, Mathis est détendu, plaisantant sur le jeu, tandis que Bénédicte semble préoccupé, répondant par des phrases courtes.", {{"Suite ...", 31}}, {0, 0, 0, 255}, "../images/Taupe/massage_mathis_bene.jpeg"});
+    taupe.scenes.push_back({30, "En cuisine, Romane partage des anecdotes amusantes, tandis que Timothée semble distraite, regardant fréquemment son téléphone.", {{"Suite ...", 31}}, {0, 0, 0, 255}, "../images/Taupe/cuisine_roro_tim.jpeg"});
+    taupe.scenes.push_back({31, "De retour dans le salon, Juliette réfléchit aux comportements observés. Des détails intrigants commencent à se connecter.", {{"Suite ...", 32}}, {0, 0, 0, 255}, "../images/Taupe/salon_reflexion.jpg"});
+    taupe.scenes.push_back({32, "Waldemar : 'Ce jeu commence à devenir sérieux. Tu vas devoir faire un choix bientôt.' Son ton semble détaché, mais son sourire en coin met Juliette mal à l’aise.", {{"Suite ...", 33}}, {0, 0, 0, 255}, "../images/Taupe/salon_wald.jpg"});
+    taupe.scenes.push_back({33, "Juliette sait qu'elle doit éliminer un groupe pour avancer. Dans quel groupe est la taupe ?", {{"Léna, Romane, Aurélien, Waldemar, Benoît", 34}, {"Mathis, Cyriel, Bénédicte, Timothée", 35}}, {0, 0, 0, 255}, "../images/Taupe/salon_choix.jpeg"});
+    taupe.scenes.push_back({34, "Juliette désigne Léna, Romane, Aurélien, Waldemar et Benoît. Mais la taupe était dans l’autre groupe ! La partie est terminée.", {{"Retour à l'écran d'accueil.", 74}}, {0, 0, 0, 255}, "../images/Taupe/defaite.jpg"});
+    taupe.scenes.push_back({35, "Juliette désigne Mathis, Cyriel, Bénédicte et Timothée. Un soulagement palpable traverse l’équipe. Elle est encore en jeu, mais la taupe reste à découvrir.", {{"Suite ...", 36}}, {0, 0, 0, 255}, "../images/Taupe/salon_choix.jpeg"});
+    taupe.scenes.push_back({36, "Juliette commence à analyser les comportements dans le groupe restant. Elle sait qu’elle doit se montrer stratégique pour repérer la taupe.", {{"Suite ...", 37}}, {0, 0, 0, 255}, "../images/Taupe/salon_choix.jpeg"});
+    taupe.scenes.push_back({37, "Les amis décident de jouer à un jeu de rôles pour détendre l’atmosphère. Chaque personne doit incarner un personnage, et Juliette observe attentivement.", {{"Suite ...", 38}}, {0, 0, 0, 255}, "../images/Taupe/salon_choix.jpeg"});
+    taupe.scenes.push_back({38, "Mathis joue un détective, tandis que Cyriel semble mal à l’aise dans son rôle. Timothée est inhabituellement enjoué, et Bénédicte reste silencieuse.", {{"Suite ...", 39}}, {0, 0, 0, 255}, "../images/Taupe/jeu_salon.jpg"});
+    taupe.scenes.push_back({39, "Juliette décide de poser une question déstabilisante : 'Si vous étiez la taupe, quelle serait votre stratégie ?'", {{"Suite ...", 40}}, {0, 0, 0, 255}, "../images/Taupe/jeu_salon.jpg"});
+    taupe.scenes.push_back({40, "Les réponses varient : Mathis plaisante et élabore une stratégie farfelue, Cyriel hésite avant de répondre, ...", {{"Suite ...", 41}}, {0, 0, 0, 255}, "../images/Taupe/jeu_salon.jpg"});
+    taupe.scenes.push_back({41, "... Bénédicte dit qu’elle essaierait de se fondre dans le décor, et Timothée déclare qu’il jouerait le rôle de l’accusateur pour détourner les soupçons.", {{"Suite ...", 42}}, {0, 0, 0, 255}, "../images/Taupe/jeu_salon.jpg"});
+    taupe.scenes.push_back({42, "Juliette réfléchit aux réponses. Et remarque une certaine similitude avec leurs comportements précédents.", {{"Suite ...", 43}}, {0, 0, 0, 255}, "../images/Taupe/jeu_salon.jpg"});
+    taupe.scenes.push_back({43, "Le lendemain matin, l'ambiance est à nouveau détendue. Celles et ceux qui sont éliminés font des remarques comiques après être allés à la pêche aux informations.", {{"Suite ...", 44}}, {0, 0, 0, 255}, "../images/Taupe/romane_lena.jpg"});
+    taupe.scenes.push_back({44, "Romane : 'Moi ... je sais qui c'est la taupe, hi hi.'", {{"Suite ...", 45}}, {0, 0, 0, 255}, "../images/Taupe/romane_lena.jpg"});
+    taupe.scenes.push_back({45, "Juliette répond agacée : 'Merci Ronron, c'est très constructif.' Puis propose d'aller faire un tour au marché. Tout le monde accepte.", {{"Suite ...", 46}}, {0, 0, 0, 255}, "../images/Taupe/romane_lena.jpg"});
+    taupe.scenes.push_back({46, "Une fois au marché, les quatre suspects restants se séparent en deux groupes. Lesquels Juliette va-t-elle suivre ?", {{"Bénédicte et Mathis", 47}, {"Cyriel et Timothée", 51}}, {0, 0, 0, 255}, "../images/Taupe/marche_0.jpg"});
+    taupe.scenes.push_back({47, "Bénédicte chuchote un mot à l'oreille de Mathis, puis il rigole. Lorsque tu l'interpelles, il évite le sujet d'un air léger.", {{"Suite ...", 48}}, {0, 0, 0, 255}, "../images/Taupe/marche_bene_mathis.jpg"});
+    taupe.scenes.push_back({48, "Vous finissez par acheter des perles. Puis Juliette laisse Bénédicte partir devant pour cuisiner Mathis.", {{"Insister sur les messes basses.", 49}, {"Extorquer des informations en échange d'un baiser.", 50}}, {0, 0, 0, 255}, "../images/Taupe/marche_mathis.jpg"});
+    taupe.scenes.push_back({49, "Mathis reste de marbre, mais il te dit qu'il pourra te révéler cette surprise bientôt.", {{"Suite ...", 52}}, {0, 0, 0, 255}, "../images/Taupe/marche_mathis.jpg"});
+    taupe.scenes.push_back({50, "Ça marche très bien, et il te dévoile que ce n'est pas lui la taupe.", {{"Suite ...", 52}}, {0, 0, 0, 255}, "../images/Taupe/marche_mathis.jpg"});
+    taupe.scenes.push_back({51, "Ils se concentrent sur les stands de chapeaux. Juliette se lasse vite d'être avec ces deux guignols.", {{"Suite ...", 52}}, {0, 0, 0, 255}, "../images/Taupe/marche_0.jpg"});
+    taupe.scenes.push_back({52, "Le soir, les amis jouent à un jeu de cartes. Chacun essaie de cacher ses émotions, mais Juliette capte des indices subtils dans leurs comportements.", {{"Suite ...", 53}}, {0, 0, 0, 255}, "../images/Taupe/jeu_carte.jpg"});
+    taupe.scenes.push_back({53, "Alors que le jeu avance, Juliette se sent prête à éliminer deux autres personnes. Qui, selon elle, ne sont pas la taupe.", {{"Mathis et Timothée", 54}, {"Bénédicte et Cyriel", 56}}, {0, 0, 0, 255}, "../images/Taupe/jeu_carte.jpg"});
+    taupe.scenes.push_back({54, "Mathis et Timothée regardent Juliette longuement. 'T'es sûre de ton choix ? Pourquoi nous avoir éliminés ?'", {{"Suite ...", 55}}, {0, 0, 0, 255}, "../images/Taupe/jeu_carte.jpg"});
+    taupe.scenes.push_back({55, "Juliette a vu juste. La taupe est parmi Bénédicte et Cyriel.", {{"Suite ...", 57}}, {0, 0, 0, 255}, "../images/Taupe/jeu_carte_suite.jpg"});
+    taupe.scenes.push_back({56, "Juliette a éliminé la taupe. Elle a perdu.", {{"Retour à l'écran d'accueil.", 74}}, {0, 0, 0, 255}, "../images/Taupe/defaite.jpg"});
+    taupe.scenes.push_back({57, "Après ce choix décisif, la tension descend pour Juliette. Elle propose de passer le lendemain matin de la journée à la plage.", {{"Suite ...", 58}}, {0, 0, 0, 255}, "../images/Taupe/jeu_carte_suite.jpg"});
+    taupe.scenes.push_back({58, "Une fois au bord de mer, tout le monde se met d'accord pour sculpter une baleine dans le sable.", {{"Suite ...", 59}}, {0, 0, 0, 255}, "../images/Taupe/baleine.jpg"});
+    taupe.scenes.push_back({59, "À la plage, Juliette décide d'interroger : Romane, Léna et Timothée. Ils sont tous d'accord mais à une condition.", {{"Suite ...", 60}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({60, "Juliette doit répondre correctement à une question de leur choix. Timothée commence.", {{"Suite ...", 61}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({61, "Timothée : 'Dans quel endroit s'est déroulée la première scène du séjour ?'", {{"Au marché", 62}, {"Sur une terrasse", 63}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({62, "Timothée : 'Non.'", {{"Suite ...", 65}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({63, "Timothée : 'Oui bravo, c'était sur une terrasse. Mon indice, c'est que la taupe a de beaux cheveux.'", {{"Suite ...", 64}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({64, "Léna pose la prochaine question : 'Quel âge a la sœur de Mathis ?'", {{"24", 66}, {"25", 65}}, {0, 0, 0, 255}, "../images/Taupe/plage_lena.jpg"});
+    taupe.scenes.push_back({65, "Léna : 'Non. Dommage.'", {{"Suite ...", 67}}, {0, 0, 0, 255}, "../images/Taupe/plage_lena.jpg"});
+    taupe.scenes.push_back({66, "Léna : 'Oui bravo, c'était 24 ans, le 30 novembre 2024. D'après moi, la taupe aime le Cenovis.'", {{"Suite ...", 67}}, {0, 0, 0, 255}, "../images/Taupe/plage_lena.jpg"});
+    taupe.scenes.push_back({67, "Romane pose la dernière question : 'Quelle est la dérivée de sin(x) ?'", {{"cos(x)", 69}, {"-cos(x)", 68}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({68, "Romane : 'Non. Je ne savais pas non plus.'", {{"Suite ...", 70}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({69, "Romane : 'Oui bravo, c'est juste. Alexandrou serait fier de toi.' Elle murmure : 'La taupe aime les bad boys.'", {{"Suite ...", 70}}, {0, 0, 0, 255}, "../images/Taupe/tim_roro_plage.jpg"});
+    taupe.scenes.push_back({70, "De retour à la maison, Juliette réfléchit à tous les indices accumulés pour prendre sa décision. Qui est la taupe ?", {{"Bénédicte", 71}, {"Cyriel", 75}}, {0, 0, 0, 255}, "../images/Taupe/decision_final.jpg"});
+    taupe.scenes.push_back({71, "Bénédicte avoue finalement qu'elle est la taupe. Juliette a gagné !", {{"Fin.", 73}}, {0, 0, 0, 255}, "../images/Taupe/victoire.jpg"});
+    taupe.scenes.push_back({72, "Juliette accuse Cyriel, mais il nie avec véhémence. Bénédicte révèle alors qu'elle est la taupe. Juliette a perdu !", {{"Retour à l'écran d'accueil.", 74}}, {0, 0, 0, 255}, "../images/Taupe/defaite.jpg"});
+    taupe.scenes.push_back({73, "Bravo mon amour, t'es trop forte. J'espère que cette expérience t'aura plu. <3", {{"Retour à l'écran d'accueil.", 74}}, {0, 0, 0, 255}, "../images/Taupe/victoire.jpg"});
+    taupe.scenes.push_back({74, "", {{}}, {}, ""});
+    setAmbience(taupe, 0, 15, SoundEffectID::AmbientTerrace);
+    setAmbience(taupe, 59, 69, SoundEffectID::AmbientSea);
+    assignVoiceClips(taupe);
+    buildTextBoxes(taupe);
+    taupe.themeMusicPath = "../audio/taupe_theme.mp3"; 
+    chapters.push_back(taupe);
+
+    return chapters;
+}
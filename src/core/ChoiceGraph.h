@@ -0,0 +1,62 @@
+#pragma once
+
+#include <climits>
+#include <vector>
+
+// A chapter's choices flattened into two arrays: the choices of scene s are
+// targets[offsets[s]] .. targets[offsets[s + 1] - 1]. Following a choice is two loads, and
+// walking the graph touches no strings. Targets outside the chapter are stored as -1.
+class ChoiceGraph {
+public:
+    static const int Unreachable = INT_MAX;
+
+    // targets[s] lists where scene s's choices lead, in order.
+    void build(const std::vector<std::vector<int>>& targets) {
+        offsets.assign(1, 0);
+        this->targets.clear();
+        int count = static_cast<int>(targets.size());
+        for (const std::vector<int>& choices : targets) {
+            for (int next : choices) {
+                this->targets.push_back(next >= 0 && next < count ? next : -1);
+            }
+            offsets.push_back(static_cast<int>(this->targets.size()));
+        }
+    }
+
+    int sceneCount() const { return static_cast<int>(offsets.size()) - 1; }
+    int choiceCount(int sceneID) const { return offsets[sceneID + 1] - offsets[sceneID]; }
+
+    // -1 when the choice does not exist or leads outside the chapter.
+    int next(int sceneID, int choice) const {
+        if (sceneID < 0 || sceneID >= sceneCount() || choice < 0 || choice >= choiceCount(sceneID)) {
+            return -1;
+        }
+        return targets[offsets[sceneID] + choice];
+    }
+
+    // Scene distances (in choices) from one scene; unreachable scenes stay at Unreachable.
+    std::vector<int> distancesFrom(int fromSceneID) const {
+        std::vector<int> distance(sceneCount(), Unreachable);
+        if (fromSceneID < 0 || fromSceneID >= sceneCount()) {
+            return distance;
+        }
+        std::vector<int> queue;
+        distance[fromSceneID] = 0;
+        queue.push_back(fromSceneID);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int sceneID = queue[head];
+            for (int i = offsets[sceneID]; i < offsets[sceneID + 1]; ++i) {
+                int next = targets[i];
+                if (next >= 0 && distance[next] == Unreachable) {
+                    distance[next] = distance[sceneID] + 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+        return distance;
+    }
+
+private:
+    std::vector<int> offsets;
+    std::vector<int> targets;
+};
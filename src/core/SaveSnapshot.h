@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Story.h"
+
+// What a save remembers: where the player is, the scenes taken to get there in this chapter,
+// and every scene ever seen, by chapter. Room for story flags is reserved in the format.
+struct SaveState {
+    static const size_t MaxPath = 256; // oldest steps are forgotten first
+
+    int chapterID = -1; // -1: the menu
+    int sceneID = 0;
+    std::vector<std::uint16_t> path;
+    std::vector<std::vector<std::uint8_t>> visited; // a bit per scene, by chapter
+
+    // Sizes the visited bits to the story, keeping what fits.
+    void fit(const Story& story) {
+        visited.resize(story.chapterCount());
+        for (int c = 0; c < story.chapterCount(); ++c) {
+            visited[c].resize((story.graph(c).sceneCount() + 7) / 8, 0);
+        }
+    }
+
+    bool hasVisited(int chapter, int scene) const {
+        return chapter >= 0 && chapter < static_cast<int>(visited.size()) && scene >= 0 &&
+               scene / 8 < static_cast<int>(visited[chapter].size()) && (visited[chapter][scene / 8] >> (scene % 8) & 1);
+    }
+
+    // Moves to a scene and remembers it; a new chapter starts a new path.
+    void enter(int chapter, int scene) {
+        if (chapter != chapterID) {
+            path.clear();
+        }
+        chapterID = chapter;
+        sceneID = scene;
+        if (path.empty() || path.back() != scene) {
+            if (path.size() == MaxPath) {
+                path.erase(path.begin());
+            }
+            path.push_back(static_cast<std::uint16_t>(scene));
+        }
+        if (chapter >= 0 && chapter < static_cast<int>(visited.size()) && scene / 8 < static_cast<int>(visited[chapter].size())) {
+            visited[chapter][scene / 8] |= static_cast<std::uint8_t>(1 << (scene % 8));
+        }
+    }
+};
+
+// Version 1 layout, little-endian:
+//
+//   header  "PMSV", u16 version, u16 header bytes, u32 payload bytes, u32 payload FNV-1a,
+//           u32 story fingerprint, u64 saved-at (ms since the epoch)
+//   payload s16 chapter, s16 scene, u16 path length, u16 flag bytes (0 for now),
+//           path as u16 scene IDs, flag bytes,
+//           u16 chapter count, then per chapter u16 bitset bytes and the bitset
+//
+// A save from an older story (fingerprint differs) or a newer format is refused, never guessed at.
+namespace save {
+
+static const char Magic[4] = {'P', 'M', 'S', 'V'};
+static const std::uint16_t Version = 1;
+static const size_t HeaderBytes = 28;
+
+// Changes whenever a chapter or scene is added or removed, so old saves cannot point past the end.
+inline std::uint32_t storyFingerprint(const Story& story) {
+    std::uint32_t hash = 2166136261u;
+    auto mix = [&hash](std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            hash = (hash ^ ((value >> (8 * i)) & 0xFF)) * 16777619u;
+        }
+    };
+    mix(static_cast<std::uint32_t>(story.chapterCount()));
+    for (int c = 0; c < story.chapterCount(); ++c) {
+        mix(static_cast<std::uint32_t>(story.graph(c).sceneCount()));
+    }
+    return hash;
+}
+
+inline std::uint32_t checksum(const std::uint8_t* bytes, size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+inline void put16(std::vector<std::uint8_t>& out, std::uint16_t value) {
+    out.push_back(static_cast<std::uint8_t>(value));
+    out.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+inline void put32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    put16(out, static_cast<std::uint16_t>(value));
+    put16(out, static_cast<std::uint16_t>(value >> 16));
+}
+
+inline void set32(std::vector<std::uint8_t>& out, size_t at, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[at + i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+// Bounds-checked little-endian reads over a mapped file.
+struct Reader {
+    const std::uint8_t* bytes;
+    size_t size;
+    size_t at = 0;
+    bool ok = true;
+
+    std::uint32_t get(int width) {
+        if (!ok || at > size || size - at < static_cast<size_t>(width)) {
+            ok = false;
+            return 0;
+        }
+        std::uint32_t value = 0;
+        for (int i = 0; i < width; ++i) {
+            value |= static_cast<std::uint32_t>(bytes[at + i]) << (8 * i);
+        }
+        at += width;
+        return value;
+    }
+    std::uint16_t get16() { return static_cast<std::uint16_t>(get(2)); }
+    std::uint32_t get32() { return get(4); }
+};
+
+// The whole file, header included, so it can go to disk in one write.
+inline void encode(const SaveState& state, std::uint32_t fingerprint, std::uint64_t savedAtMs, std::vector<std::uint8_t>& out) {
+    out.clear();
+    for (char c : Magic) {
+        out.push_back(static_cast<std::uint8_t>(c));
+    }
+    put16(out, Version);
+    put16(out, static_cast<std::uint16_t>(HeaderBytes));
+    put32(out, 0); // payload bytes, filled in below
+    put32(out, 0); // payload checksum
+    put32(out, fingerprint);
+    put32(out, static_cast<std::uint32_t>(savedAtMs));
+    put32(out, static_cast<std::uint32_t>(savedAtMs >> 32));
+
+    put16(out, static_cast<std::uint16_t>(static_cast<std::int16_t>(state.chapterID)));
+    put16(out, static_cast<std::uint16_t>(state.sceneID));
+    put16(out, static_cast<std::uint16_t>(state.path.size()));
+    put16(out, 0); // story flags
+    for (std::uint16_t scene : state.path) {
+        put16(out, scene);
+    }
+    put16(out, static_cast<std::uint16_t>(state.visited.size()));
+    for (const std::vector<std::uint8_t>& bits : state.visited) {
+        put16(out, static_cast<std::uint16_t>(bits.size()));
+        out.insert(out.end(), bits.begin(), bits.end());
+    }
+    set32(out, 8, static_cast<std::uint32_t>(out.size() - HeaderBytes));
+    set32(out, 12, checksum(out.data() + HeaderBytes, out.size() - HeaderBytes));
+}
+
+// False, leaving state alone, for a truncated, corrupt, foreign or out-of-date save.
+inline bool decode(const void* data, size_t size, std::uint32_t fingerprint, SaveState& state) {
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    if (size < HeaderBytes || std::memcmp(bytes, Magic, 4) != 0) {
+        return false;
+    }
+    Reader header = {bytes, size};
+    header.at = 4;
+    std::uint16_t version = header.get16();
+    std::uint16_t headerBytes = header.get16();
+    std::uint32_t payloadBytes = header.get32();
+    std::uint32_t payloadChecksum = header.get32();
+    std::uint32_t savedFingerprint = header.get32();
+    if (version != Version || headerBytes != HeaderBytes || savedFingerprint != fingerprint || payloadBytes != size - HeaderBytes ||
+        checksum(bytes + HeaderBytes, payloadBytes) != payloadChecksum) {
+        return false;
+    }
+
+    Reader payload = {bytes + HeaderBytes, payloadBytes};
+    SaveState loaded;
+    loaded.chapterID = static_cast<std::int16_t>(payload.get16());
+    loaded.sceneID = payload.get16();
+    std::uint16_t pathLength = payload.get16();
+    std::uint16_t flagBytes = payload.get16();
+    if (pathLength > SaveState::MaxPath) {
+        return false;
+    }
+    for (std::uint16_t i = 0; i < pathLength && payload.ok; ++i) {
+        loaded.path.push_back(payload.get16());
+    }
+    if (!payload.ok || payload.size - payload.at < flagBytes) {
+        return false;
+    }
+    payload.at += flagBytes; // none written yet; skipped, so later writers stay readable
+    std::uint16_t chapters = payload.get16();
+    for (std::uint16_t c = 0; c < chapters && payload.ok; ++c) {
+        std::uint16_t bitBytes = payload.get16();
+        if (!payload.ok || payload.size - payload.at < bitBytes) {
+            return false;
+        }
+        loaded.visited.emplace_back(payload.bytes + payload.at, payload.bytes + payload.at + bitBytes);
+        payload.at += bitBytes;
+    }
+    if (!payload.ok || payload.at != payload.size) {
+        return false;
+    }
+    state = std::move(loaded);
+    return true;
+}
+
+} // namespace save
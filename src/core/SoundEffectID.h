@@ -0,0 +1,13 @@
+#pragma once
+
+// Effects known to the game. Scenes and UI code refer to effects by these IDs.
+enum class SoundEffectID : int {
+    None = -1,
+    ChoiceConfirm,
+    PageTurn,
+    MenuSelect,
+    AmbientCity,
+    AmbientSea,
+    AmbientTerrace,
+    Count
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ChoiceGraph.h"
+#include "SoundEffectID.h"
+
+// The story model: plain data with no SDL types, so it can be loaded, walked and benchmarked
+// without a window. The game turns it into pixels and sound.
+
+struct Color {
+    std::uint8_t r;
+    std::uint8_t g;
+    std::uint8_t b;
+    std::uint8_t a;
+};
+
+// Struct for a choice the player can make
+struct Choice {
+    std::string text;
+    int nextSceneID; // The ID of the scene that follows this choice
+};
+
+// Struct for a scene that contains dialogue and choices. A scene's ID is its index in the chapter.
+struct Scene {
+    int id;
+    std::string dialogue;
+    std::vector<Choice> choices;
+    Color bgColor; // Background color for the scene
+    std::string imagePath; // Path to the image to be displayed
+    SoundEffectID ambientEffect = SoundEffectID::None; // Loop played under the scene
+    std::string voicePath; // Voice-over for the dialogue, empty if the line is not voiced
+    std::string textBox; // Dialogue and numbered choices as shown, built once by buildTextBoxes
+};
+
+// Struct for a chapter. Its last scene is an empty ending that leads back to the menu.
+struct Chapter {
+    std::string title;
+    std::vector<Scene> scenes;
+    std::string themeMusicPath; // Path to the theme music for this chapter
+};
+
+// The dialogue followed by the numbered choices, as shown in the scene's text box
+inline std::string sceneText(const Scene& scene) {
+    std::string textBox = scene.dialogue;
+    for (size_t i = 0; i < scene.choices.size(); ++i) {
+        textBox += "\n" + std::to_string(i + 1) + ". " + scene.choices[i].text;
+    }
+    return textBox;
+}
+
+// Built once at load so rendering a scene does not assemble its text every frame.
+inline void buildTextBoxes(Chapter& chapter) {
+    for (Scene& scene : chapter.scenes) {
+        scene.textBox = sceneText(scene);
+    }
+}
+
+inline void setAmbience(Chapter& chapter, int firstSceneID, int lastSceneID, SoundEffectID effect) {
+    for (Scene& scene : chapter.scenes) {
+        if (scene.id >= firstSceneID && scene.id <= lastSceneID) {
+            scene.ambientEffect = effect;
+        }
+    }
+}
+
+// Voice clips live in ../audio/voice/<chapter title>/<scene id>.ogg.
+inline void assignVoiceClips(Chapter& chapter) {
+    for (Scene& scene : chapter.scenes) {
+        if (!scene.dialogue.empty()) {
+            scene.voicePath = "../audio/voice/" + chapter.title + "/" + std::to_string(scene.id) + ".ogg";
+        }
+    }
+}
+
+// The chapters as written, with ambience, voice clips and text boxes filled in. Chapters.cpp.
+std::vector<Chapter> buildChapters();
+
+// Every chapter with its choice graph, built once at load and read-only afterwards.
+class Story {
+public:
+    void setChapters(std::vector<Chapter> newChapters) {
+        chapters = std::move(newChapters);
+        graphs.assign(chapters.size(), ChoiceGraph());
+        for (size_t i = 0; i < chapters.size(); ++i) {
+            std::vector<std::vector<int>> targets(chapters[i].scenes.size());
+            for (size_t s = 0; s < chapters[i].scenes.size(); ++s) {
+                for (const Choice& choice : chapters[i].scenes[s].choices) {
+                    targets[s].push_back(choice.nextSceneID);
+                }
+            }
+            graphs[i].build(targets);
+        }
+    }
+
+    int chapterCount() const { return static_cast<int>(chapters.size()); }
+    const Chapter& chapter(int chapterID) const { return chapters[chapterID]; }
+    const ChoiceGraph& graph(int chapterID) const { return graphs[chapterID]; }
+    const std::vector<Chapter>& getChapters() const { return chapters; }
+
+private:
+    std::vector<Chapter> chapters;
+    std::vector<ChoiceGraph> graphs; // one per chapter
+};
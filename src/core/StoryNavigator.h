@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Story.h"
+
+// Where the player is: the chapter menu, or a scene of a chapter. Every move is checked against
+// the choice graph and nothing here allocates, so the frontends only ask what to show.
+class StoryNavigator {
+public:
+    static const int Menu = -1; // chapter ID while the menu is up
+
+    void reset(const Story& newStory) {
+        story = &newStory;
+        returnToMenu();
+    }
+
+    bool inMenu() const { return chapterID == Menu; }
+    int getChapterID() const { return chapterID; }
+    int getSceneID() const { return sceneID; }
+    const Chapter& chapter() const { return story->chapter(chapterID); }
+    const Scene& scene() const { return story->chapter(chapterID).scenes[sceneID]; }
+    const ChoiceGraph& graph() const { return story->graph(chapterID); }
+
+    // Opens a chapter at its first scene. False if there is no such chapter.
+    bool selectChapter(int newChapterID) {
+        if (newChapterID < 0 || newChapterID >= story->chapterCount() || story->graph(newChapterID).sceneCount() == 0) {
+            return false;
+        }
+        chapterID = newChapterID;
+        sceneID = 0;
+        return true;
+    }
+
+    bool canChoose(int choice) const { return !inMenu() && story->graph(chapterID).next(sceneID, choice) >= 0; }
+
+    // Follows the scene's choice (0-based). False if the scene has no such choice.
+    bool choose(int choice) {
+        if (!canChoose(choice)) {
+            return false;
+        }
+        sceneID = story->graph(chapterID).next(sceneID, choice);
+        return true;
+    }
+
+    // Jumps to a scene of the current chapter as if a choice had led there.
+    bool goToScene(int newSceneID) {
+        if (inMenu() || newSceneID < 0 || newSceneID >= story->graph(chapterID).sceneCount()) {
+            return false;
+        }
+        sceneID = newSceneID;
+        return true;
+    }
+
+    // The chapter's last scene is an empty ending; reaching it means going back to the menu.
+    bool atEnding() const { return !inMenu() && sceneID == story->graph(chapterID).sceneCount() - 1; }
+
+    void returnToMenu() {
+        chapterID = Menu;
+        sceneID = 0;
+    }
+
+private:
+    const Story* story = nullptr;
+    int chapterID = Menu;
+    int sceneID = 0;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "StoryNavigator.h"
+
+// One player of the text service: a cursor into the shared story plus the scenes visited in the
+// current chapter, so BACK can undo a choice. Commands are single lines; every reply ends with
+// an empty line.
+//
+//   MENU        the chapter list              -> MENU <count>, then "1. Poulpe" ...
+//   START <n>   open chapter n (1-based)      -> SCENE <chapter> <scene> <choices>, then the text box
+//   CHOOSE <n>  follow choice n (1-based)     -> SCENE ..., or MENU ... after an ending
+//   BACK        undo the last choice          -> SCENE ...
+//   LOOK        the current scene again       -> SCENE ... or MENU ...
+//
+// Anything else gets ERR <reason>.
+class StorySession {
+public:
+    static const size_t MaxHistory = 256; // oldest choices are forgotten first
+
+    explicit StorySession(const Story& story) : story(story) { navigator.reset(story); }
+
+    // Appends the reply to out.
+    void handle(const char* line, size_t length, std::string& out) {
+        ++requests;
+        if (matches(line, length, "MENU")) {
+            navigator.returnToMenu();
+            history.clear();
+            appendMenu(out);
+        } else if (matches(line, length, "START ")) {
+            if (!navigator.selectChapter(argument(line, length, 6) - 1)) {
+                appendError(out, "no such chapter");
+                return;
+            }
+            history.clear();
+            appendScene(out);
+        } else if (matches(line, length, "CHOOSE ")) {
+            int from = navigator.getSceneID();
+            if (!navigator.choose(argument(line, length, 7) - 1)) {
+                appendError(out, "no such choice");
+                return;
+            }
+            if (history.size() == MaxHistory) {
+                history.erase(history.begin());
+            }
+            history.push_back(from);
+            if (navigator.atEnding()) {
+                navigator.returnToMenu();
+                history.clear();
+                appendMenu(out);
+                return;
+            }
+            appendScene(out);
+        } else if (matches(line, length, "BACK")) {
+            if (history.empty() || !navigator.goToScene(history.back())) {
+                appendError(out, "nothing to undo");
+                return;
+            }
+            history.pop_back();
+            appendScene(out);
+        } else if (matches(line, length, "LOOK")) {
+            if (navigator.inMenu()) {
+                appendMenu(out);
+            } else {
+                appendScene(out);
+            }
+        } else {
+            appendError(out, "unknown command");
+        }
+    }
+
+    std::uint64_t getRequests() const { return requests; }
+
+private:
+    const Story& story;
+    StoryNavigator navigator;
+    std::vector<int> history;
+    std::uint64_t requests = 0;
+
+    static bool matches(const char* line, size_t length, const char* command) {
+        size_t commandLength = std::strlen(command);
+        return length >= commandLength && std::memcmp(line, command, commandLength) == 0;
+    }
+
+    // The number after the command, or 0 if there is none.
+    static int argument(const char* line, size_t length, size_t offset) {
+        int value = 0;
+        for (size_t i = offset; i < length && line[i] >= '0' && line[i] <= '9' && value < 100000; ++i) {
+            value = value * 10 + (line[i] - '0');
+        }
+        return value;
+    }
+
+    void appendMenu(std::string& out) const {
+        out += "MENU ";
+        out += std::to_string(story.chapterCount());
+        out += '\n';
+        for (int i = 0; i < story.chapterCount(); ++i) {
+            out += std::to_string(i + 1);
+            out += ". ";
+            out += story.chapter(i).title;
+            out += '\n';
+        }
+        out += '\n';
+    }
+
+    void appendScene(std::string& out) const {
+        const Scene& scene = navigator.scene();
+        out += "SCENE ";
+        out += std::to_string(navigator.getChapterID() + 1);
+        out += ' ';
+        out += std::to_string(navigator.getSceneID());
+        out += ' ';
+        out += std::to_string(navigator.graph().choiceCount(navigator.getSceneID()));
+        out += '\n';
+        out += scene.textBox;
+        out += "\n\n";
+    }
+
+    static void appendError(std::string& out, const char* reason) {
+        out += "ERR ";
+        out += reason;
+        out += "\n\n";
+    }
+};
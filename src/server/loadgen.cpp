@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Load generator for pamplemousse_server: opens --sessions connections over --threads threads
+// and has each one play through the story with random choices, one request in flight per
+// session. Reports requests per second and the latency distribution of the replies.
+
+struct LoadOptions {
+    int port = 7070;
+    int sessions = 1000;
+    int threads = 2;
+    double seconds = 5.0;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+struct Session {
+    int fd = -1;
+    std::string reply;
+    Clock::time_point sent;
+    unsigned int random = 0;
+};
+
+struct ThreadResult {
+    std::vector<float> latencyUs;
+    unsigned long long errors = 0;   // connections lost or refused
+    unsigned long long rejected = 0; // ERR replies, e.g. a choice leading to a missing scene
+    int connected = 0;
+};
+
+static LoadOptions parseLoadOptions(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            options.sessions = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options.seconds = std::atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+        }
+    }
+    return options;
+}
+
+// Thousands of sessions need more descriptors than the usual soft limit of 1024.
+static void raiseDescriptorLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static int connectToServer(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return fd;
+}
+
+static unsigned int nextRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// The request that follows a reply: pick a chapter from the menu, a choice in a scene.
+static std::string nextRequest(Session& session) {
+    int a = 0, b = 0, choices = 0;
+    if (std::sscanf(session.reply.c_str(), "MENU %d", &a) == 1 && a > 0) {
+        return "START " + std::to_string(nextRandom(session.random) % a + 1) + "\n";
+    }
+    if (std::sscanf(session.reply.c_str(), "SCENE %d %d %d", &a, &b, &choices) == 3 && choices > 0) {
+        return "CHOOSE " + std::to_string(nextRandom(session.random) % choices + 1) + "\n";
+    }
+    return "MENU\n";
+}
+
+static bool sendRequest(Session& session, const std::string& request) {
+    session.sent = Clock::now();
+    // Requests are a few bytes, well under the socket buffer, so one send takes all of it.
+    return send(session.fd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size());
+}
+
+static void runThread(const LoadOptions& options, int sessionCount, unsigned int seed, ThreadResult& result) {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        return;
+    }
+    std::vector<Session> sessions(sessionCount);
+    for (int i = 0; i < sessionCount; ++i) {
+        Session& session = sessions[i];
+        session.fd = connectToServer(options.port);
+        if (session.fd < 0) {
+            ++result.errors;
+            continue;
+        }
+        session.random = seed + static_cast<unsigned int>(i) * 2654435761u + 1;
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, session.fd, &event);
+        ++result.connected;
+        if (!sendRequest(session, "MENU\n")) {
+            ++result.errors;
+        }
+    }
+
+    Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    epoll_event events[256];
+    char buffer[4096];
+    while (Clock::now() < end) {
+        int count = epoll_wait(epollFd, events, 256, 100);
+        for (int e = 0; e < count; ++e) {
+            Session& session = sessions[events[e].data.u32];
+            ssize_t received = recv(session.fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                ++result.errors;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, session.fd, nullptr);
+                continue;
+            }
+            session.reply.append(buffer, static_cast<size_t>(received));
+            if (session.reply.find("\n\n") == std::string::npos) {
+                continue; // the rest of the reply is still on its way
+            }
+            std::chrono::duration<float, std::micro> latency = Clock::now() - session.sent;
+            result.latencyUs.push_back(latency.count());
+            if (session.reply.compare(0, 4, "ERR ") == 0) {
+                ++result.rejected;
+            }
+            std::string request = nextRequest(session);
+            session.reply.clear();
+            if (!sendRequest(session, request)) {
+                ++result.errors;
+            }
+        }
+    }
+    for (Session& session : sessions) {
+        if (session.fd >= 0) {
+            close(session.fd);
+        }
+    }
+    close(epollFd);
+}
+
+static float percentile(const std::vector<float>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0f;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options = parseLoadOptions(argc, argv);
+    raiseDescriptorLimit();
+
+    std::vector<ThreadResult> results(options.threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; ++t) {
+        int count = options.sessions / options.threads + (t < options.sessions % options.threads ? 1 : 0);
+        threads.emplace_back(runThread, std::cref(options), count, 0x9E3779B9u * (t + 1), std::ref(results[t]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    // Each thread connects first and then runs for --seconds, so that is the measured window.
+    double seconds = options.seconds;
+
+    std::vector<float> latencies;
+    unsigned long long errors = 0;
+    unsigned long long rejected = 0;
+    int connected = 0;
+    for (ThreadResult& result : results) {
+        latencies.insert(latencies.end(), result.latencyUs.begin(), result.latencyUs.end());
+        errors += result.errors;
+        rejected += result.rejected;
+        connected += result.connected;
+    }
+    if (connected == 0) {
+        fprintf(stderr, "Cannot connect to 127.0.0.1:%d\n", options.port);
+        return 2;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << connected << " sessions, " << latencies.size() << " requests in " << seconds << " s: " << latencies.size() / seconds
+              << " requests/s" << std::endl;
+    std::cout << "Latency: p50 " << percentile(latencies, 0.50) << " us, p99 " << percentile(latencies, 0.99) << " us, max "
+              << (latencies.empty() ? 0.0f : latencies.back()) << " us; " << rejected << " rejected, " << errors << " errors" << std::endl;
+    return errors ? 1 : 0;
+}
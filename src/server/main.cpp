@@ -0,0 +1,328 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/Story.h"
+#include "../core/StorySession.h"
+
+// The stories as a line-based text service (see StorySession for the commands), for many players
+// at once. One copy of the chapters is shared read-only by every session; a session is a cursor
+// and a short history. Each worker thread runs its own epoll loop and accepts from the shared
+// listening socket, so connections spread over the workers and never move between them.
+// Only 127.0.0.1 is bound.
+
+struct ServerOptions {
+    int port = 7070;
+    int workers = 0; // 0 uses one per core
+};
+
+static const int PollMs = 200;              // how quickly a stop request is noticed
+static const size_t MaxLineBytes = 1024;    // longer requests close the connection
+static const size_t MaxPendingBytes = 1 << 20; // a client that stops reading is dropped
+
+static std::atomic<bool> stopping{false};
+
+static void requestStop(int) {
+    stopping.store(true);
+}
+
+struct WorkerStats {
+    unsigned long long sessions;
+    unsigned long long requests;
+};
+
+struct Connection {
+    int fd;
+    StorySession session;
+    std::string input;
+    std::string output;
+    size_t written = 0;
+    uint32_t events = EPOLLIN | EPOLLRDHUP; // what epoll watches for
+    bool peerClosed = false;                // the client is done sending; reply, then close
+
+    Connection(int fd, const Story& story) : fd(fd), session(story) {}
+};
+
+class Worker {
+public:
+    Worker(int listenFd, const Story& story) : listenFd(listenFd), story(story) {}
+
+    ~Worker() {
+        for (auto& entry : connections) {
+            close(entry.first);
+        }
+        if (epollFd >= 0) {
+            close(epollFd);
+        }
+    }
+
+    bool start() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            return false;
+        }
+        // Every worker waits on the listener; EPOLLEXCLUSIVE wakes one of them per connection.
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.fd = listenFd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0) {
+            return false;
+        }
+        thread = std::thread([this]() { loop(); });
+        return true;
+    }
+
+    void join() {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    WorkerStats stats() const { return {accepted.load(), requests.load()}; }
+
+private:
+    int listenFd;
+    const Story& story;
+    int epollFd = -1;
+    std::thread thread;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::atomic<unsigned long long> accepted{0};
+    std::atomic<unsigned long long> requests{0};
+
+    void loop() {
+        epoll_event events[256];
+        while (!stopping.load()) {
+            int count = epoll_wait(epollFd, events, 256, PollMs);
+            for (int i = 0; i < count; ++i) {
+                if (events[i].data.fd == listenFd) {
+                    acceptAll();
+                    continue;
+                }
+                auto it = connections.find(events[i].data.fd);
+                if (it == connections.end()) {
+                    continue;
+                }
+                Connection& connection = *it->second;
+                bool open = !(events[i].events & (EPOLLHUP | EPOLLERR));
+                if (open && (events[i].events & (EPOLLIN | EPOLLRDHUP)) && !connection.peerClosed) {
+                    open = readRequests(connection);
+                }
+                if (open && (!connection.output.empty() || connection.peerClosed)) {
+                    open = writeReplies(connection);
+                }
+                if (open && connection.peerClosed && connection.output.empty()) {
+                    open = false; // everything it asked for has been answered
+                }
+                if (!open) {
+                    closeConnection(connection.fd);
+                }
+            }
+        }
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return; // EAGAIN: another worker took it, or the backlog is empty
+            }
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                close(fd);
+                continue;
+            }
+            connections[fd].reset(new Connection(fd, story));
+            accepted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Reads what is available and answers each complete line as it arrives. A client that has
+    // finished sending is marked peerClosed and still gets its replies. False when the connection
+    // must close now: an error, an overlong line, or a client that does not read its replies.
+    bool readRequests(Connection& connection) {
+        char buffer[4096];
+        while (true) {
+            ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received == 0) {
+                connection.peerClosed = true;
+                return true;
+            }
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            connection.input.append(buffer, static_cast<size_t>(received));
+            answerLines(connection);
+            // Checked per read, so a client cannot make the server buffer without bound. Replies
+            // over the cap are sent first; only a client that is not reading them is dropped.
+            if (connection.input.size() > MaxLineBytes) {
+                return false;
+            }
+            if (pendingBytes(connection) > MaxPendingBytes && (!writeReplies(connection) || pendingBytes(connection) > MaxPendingBytes)) {
+                return false;
+            }
+        }
+    }
+
+    static size_t pendingBytes(const Connection& connection) { return connection.output.size() - connection.written; }
+
+    void answerLines(Connection& connection) {
+        size_t start = 0;
+        unsigned long long answered = 0;
+        for (size_t end = connection.input.find('\n'); end != std::string::npos; end = connection.input.find('\n', start)) {
+            size_t length = end - start;
+            if (length && connection.input[end - 1] == '\r') {
+                --length;
+            }
+            connection.session.handle(connection.input.data() + start, length, connection.output);
+            ++answered;
+            start = end + 1;
+        }
+        connection.input.erase(0, start);
+        requests.fetch_add(answered, std::memory_order_relaxed);
+    }
+
+    // Sends what the socket takes; waits for EPOLLOUT for the rest. False when the peer is gone.
+    bool writeReplies(Connection& connection) {
+        while (connection.written < connection.output.size()) {
+            ssize_t sent = send(connection.fd, connection.output.data() + connection.written, connection.output.size() - connection.written,
+                                MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                return false;
+            }
+            connection.written += static_cast<size_t>(sent);
+        }
+        bool pending = pendingBytes(connection) > 0;
+        if (!pending) {
+            connection.output.clear();
+            connection.written = 0;
+        }
+        // Once the client has stopped sending, only wait for room to send the rest.
+        uint32_t wanted = (connection.peerClosed ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP)) |
+                          (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        if (wanted != connection.events) {
+            epoll_event event = {};
+            event.events = wanted;
+            event.data.fd = connection.fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.events = wanted;
+        }
+        return true;
+    }
+
+    void closeConnection(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    }
+};
+
+static ServerOptions parseServerOptions(int argc, char* argv[]) {
+    ServerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            options.workers = std::atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+        }
+    }
+    return options;
+}
+
+// One descriptor per session; the usual soft limit of 1024 would cap the server well short.
+static void raiseDescriptorLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static int listenOnLoopback(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char* argv[]) {
+    ServerOptions options = parseServerOptions(argc, argv);
+    int workerCount = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    workerCount = workerCount > 0 ? workerCount : 1;
+
+    Story story;
+    story.setChapters(buildChapters());
+
+    raiseDescriptorLimit();
+    int listenFd = listenOnLoopback(options.port);
+    if (listenFd < 0) {
+        fprintf(stderr, "Cannot listen on 127.0.0.1:%d: %s\n", options.port, std::strerror(errno));
+        return 2;
+    }
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(new Worker(listenFd, story));
+        if (!workers.back()->start()) {
+            fprintf(stderr, "Cannot start worker: %s\n", std::strerror(errno));
+            stopping.store(true);
+            workers.pop_back();
+            break;
+        }
+    }
+    std::cout << "Serving " << story.chapterCount() << " chapters on 127.0.0.1:" << options.port << " with " << workers.size()
+              << " workers" << std::endl;
+
+    unsigned long long sessions = 0;
+    unsigned long long requests = 0;
+    for (std::unique_ptr<Worker>& worker : workers) {
+        worker->join();
+        WorkerStats stats = worker->stats();
+        sessions += stats.sessions;
+        requests += stats.requests;
+    }
+    close(listenFd);
+    std::cout << "Served " << sessions << " sessions, " << requests << " requests" << std::endl;
+    return 0;
+}